@@ -0,0 +1,408 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#include "bench.h"
+#include "pdm_cfg.h"
+#include "tlv_link.h"
+#include "pcm_codec.h"
+
+#if defined(CONFIG_PDM_CODEC_MFCC)
+#include "mfcc.h"
+#endif
+
+#if defined(CONFIG_PDM_NS)
+#include "ns.h"
+#include "ns_kernels.h"
+#endif
+
+#if defined(CONFIG_PDM_LEVEL)
+#include "level.h"
+#include "level_kernels.h"
+#endif
+
+#if defined(CONFIG_PDM_DECIM)
+#include "decim.h"
+#include "decim_kernels.h"
+#endif
+
+#if defined(CONFIG_ARCH_POSIX)
+#include <native_rtc.h>
+#endif
+
+/* Written by the TX thread only, read once bench_drain() has returned */
+static uint64_t tx_busy_ns;
+
+/*
+ * native_sim runs code in zero simulated time, so there the host clock is
+ * used instead of the cycle counter (qemu with icount and real hardware
+ * count cycles).
+ */
+uint64_t bench_now_ns(void)
+{
+#if defined(CONFIG_ARCH_POSIX)
+    return native_rtc_gettime_us(RTC_CLOCK_REALTIME) * 1000u;
+#else
+    return k_cyc_to_ns_floor64(k_cycle_get_32());
+#endif
+}
+
+void bench_tx_busy(uint64_t ns)
+{
+    tx_busy_ns += ns;
+}
+
+/* Wait until the TX thread has released every block we fed it */
+static void bench_drain(struct k_mem_slab *slab)
+{
+    while (k_mem_slab_num_used_get(slab) != 0) {
+        k_sleep(K_MSEC(1));
+    }
+    tlv_link_flush();
+}
+
+/*
+ * TX thread busy time per block, wall time for context. The TX thread
+ * times each batch with bench_now_ns() from the first block to the send
+ * returning, less the wait for a free tlv_link job, so a full link does not
+ * count as work: poll mode is charged for pushing out every byte, async
+ * mode only for queueing the frame. Both run on native_sim and hardware;
+ * the qemu UARTs have no async API, so qemu reports poll mode only.
+ */
+static void bench_tx_mode(enum tlv_link_mode mode, struct k_mem_slab *slab,
+                          size_t block_bytes, bench_feed_fn feed)
+{
+    const int blocks = CONFIG_PDM_BENCH_BLOCKS;
+    const char *name = (mode == TLV_LINK_MODE_ASYNC) ? "async" : "poll";
+
+    if (tlv_link_set_mode(mode)) {
+        printk("bench tx %-5s: not supported on this UART\n", name);
+        return;
+    }
+
+    uint64_t busy0 = tx_busy_ns;
+    int64_t  t0    = k_uptime_get();
+
+    for (int i = 0; i < blocks; i++) {
+        void *buf;
+
+        k_mem_slab_alloc(slab, &buf, K_FOREVER);
+        memset(buf, (uint8_t)i, block_bytes);
+        feed(buf, block_bytes);
+    }
+    bench_drain(slab);
+
+    uint64_t busy = tx_busy_ns - busy0;
+    int64_t  ms   = k_uptime_get() - t0;
+
+    printk("\nbench tx %-5s: %d blocks x %u B, tx busy %llu us/block, wall %lld ms\n",
+           name, blocks, (unsigned int)block_bytes, busy / blocks / 1000u, ms);
+}
+
+/* Deterministic test signal: triangle + LFSR noise, roughly room audio */
+static void bench_fill(int16_t *pcm, size_t n, uint32_t *lfsr)
+{
+    static int32_t phase;
+
+    for (size_t i = 0; i < n; i++) {
+        *lfsr = (*lfsr >> 1) ^ (-(*lfsr & 1u) & 0xB400u);
+        phase = (phase + 97) & 0x3FFF;
+        int32_t tri = (phase < 0x2000) ? phase : 0x3FFF - phase;
+        pcm[i] = (int16_t)((tri - 0x1000) * 2 + (int16_t)(*lfsr & 0x3FF) - 0x200);
+    }
+}
+
+static uint8_t __aligned(4) enc[MAX(1, PCM_CODEC_OUT_BYTES(BLOCK_MAX_BYTES))];
+
+/* Encoder cost per block of the selected codec, measured in isolation */
+static void bench_codec(struct k_mem_slab *slab, size_t block_bytes)
+{
+    const int blocks = CONFIG_PDM_BENCH_BLOCKS;
+    uint32_t lfsr = 0xACE1u;
+    uint64_t ns = 0;
+    size_t enc_bytes = 0;
+    void *buf;
+
+    k_mem_slab_alloc(slab, &buf, K_FOREVER);
+    pcm_codec_reset();
+
+    for (int i = 0; i < blocks; i++) {
+        bench_fill(buf, block_bytes / sizeof(int16_t), &lfsr);
+
+        uint16_t len;
+        uint64_t t0 = bench_now_ns();
+
+        pcm_codec_encode(buf, (uint16_t)block_bytes, enc, &len);
+        ns += bench_now_ns() - t0;
+        enc_bytes += len;
+    }
+    k_mem_slab_free(slab, buf);
+    pcm_codec_reset();
+
+    uint64_t ns_block = ns / blocks;
+    uint64_t cyc_block = ns_block * sys_clock_hw_cycles_per_sec() / 1000000000u;
+    printk("\nbench codec: %llu ns/block (%llu cycles @ %u Hz), %u -> %u B/block\n",
+           ns_block, cyc_block, sys_clock_hw_cycles_per_sec(), (unsigned int)block_bytes,
+           (unsigned int)(enc_bytes / blocks));
+
+    /* Real-time budget: the block has to be encoded before the next one is captured */
+    const struct pdm_stream_cfg *c = pdm_stream_cfg_get();
+    uint64_t budget_ns = (uint64_t)c->block_ms * 1000000u;
+    uint32_t permille = (uint32_t)(ns_block * 1000u / budget_ns);
+
+    printk("bench codec: %u.%u%% of the %u ms block budget\n",
+           permille / 10, permille % 10, c->block_ms);
+#if defined(CONFIG_PDM_CODEC_MFCC)
+    uint32_t spb = pdm_stream_spb(c);
+
+    printk("bench mfcc: %llu cycles/vector (%u samples, hop %u, %u mels, %u coefs)\n",
+           cyc_block * MFCC_HOP / spb, MFCC_FRAME_LEN, MFCC_HOP, MFCC_MELS, MFCC_COEFS);
+#endif
+}
+
+#if defined(CONFIG_PDM_NS)
+#if PDM_SIMD
+/* C vs DSP kernels on the same data, one NS frame's worth of work each */
+static void bench_ns_kernels(void)
+{
+    static int16_t x[2 * NS_FFT_SIZE] __aligned(4);
+    static int16_t w[NS_FRAME] __aligned(4);
+    static int16_t a[2 * NS_FFT_SIZE] __aligned(4);
+    static int16_t b[2 * NS_FFT_SIZE] __aligned(4);
+    static uint32_t pa[NS_BINS];
+    static uint32_t pb[NS_BINS];
+    const int reps = CONFIG_PDM_BENCH_BLOCKS;
+    uint32_t lfsr = 0x1D2Bu;
+    uint32_t t0, c_cyc, dsp_cyc;
+
+    bench_fill(x, ARRAY_SIZE(x), &lfsr);
+    bench_fill(w, ARRAY_SIZE(w), &lfsr);
+    for (size_t i = 0; i < ARRAY_SIZE(w); i++) {
+        w[i] &= 0x7FFF;
+    }
+
+    t0 = k_cycle_get_32();
+    for (int r = 0; r < reps; r++) {
+        ns_window_c(a, x, w, NS_FRAME);
+        ns_power_c(pa, x, NS_BINS);
+        ns_gain_c(a, w, NS_FRAME / 2);
+        ns_ola_c(a, x, NS_FRAME);
+    }
+    c_cyc = k_cycle_get_32() - t0;
+
+    t0 = k_cycle_get_32();
+    for (int r = 0; r < reps; r++) {
+        ns_window_dsp(b, x, w, NS_FRAME);
+        ns_power_dsp(pb, x, NS_BINS);
+        ns_gain_dsp(b, w, NS_FRAME / 2);
+        ns_ola_dsp(b, x, NS_FRAME);
+    }
+    dsp_cyc = k_cycle_get_32() - t0;
+
+    bool same = memcmp(a, b, NS_FRAME * sizeof(int16_t)) == 0 && memcmp(pa, pb, sizeof(pa)) == 0;
+    printk("bench ns kernels: c %u, dsp %u cycles/frame, results %s\n",
+           c_cyc / reps, dsp_cyc / reps, same ? "identical" : "DIFFER");
+}
+#endif
+
+/* Noise suppressor cost per block, on top of whatever the codec costs */
+static void bench_ns(struct k_mem_slab *slab, size_t block_bytes)
+{
+    const int blocks = CONFIG_PDM_BENCH_BLOCKS;
+    const struct pdm_stream_cfg *c = pdm_stream_cfg_get();
+    uint32_t lfsr = 0xACE1u;
+    uint64_t ns = 0;
+    void *buf;
+
+    k_mem_slab_alloc(slab, &buf, K_FOREVER);
+    ns_reset();
+    ns_set_enabled(true);
+
+    for (int i = 0; i < blocks; i++) {
+        bench_fill(buf, block_bytes / sizeof(int16_t), &lfsr);
+
+        uint64_t t0 = bench_now_ns();
+        ns_block(buf, block_bytes / sizeof(int16_t), 1);
+        ns += bench_now_ns() - t0;
+    }
+    k_mem_slab_free(slab, buf);
+
+    uint64_t ns_block_ns = ns / blocks;
+    uint32_t permille = (uint32_t)(ns_block_ns * 1000u / ((uint64_t)c->block_ms * 1000000u));
+
+    printk("\nbench ns: %llu ns/block (%llu cycles), %u.%u%% of the %u ms block budget, %s kernels\n",
+           ns_block_ns, ns_block_ns * sys_clock_hw_cycles_per_sec() / 1000000000u,
+           permille / 10, permille % 10, c->block_ms, PDM_SIMD ? "dsp" : "c");
+#if PDM_SIMD
+    bench_ns_kernels();
+#endif
+}
+#endif
+
+#if defined(CONFIG_PDM_LEVEL)
+typedef void (*bench_level_fn)(int16_t *x, uint32_t n);
+
+static void bench_dc_c(int16_t *x, uint32_t n)
+{
+    static struct dc_block_state st = { .a_q14 = 16255 };
+
+    dc_block_c(&st, x, n);
+}
+
+static void bench_agc_c(int16_t *x, uint32_t n)
+{
+    agc_ramp_c(x, n, 2048, 1);
+}
+
+#if PDM_SIMD
+static void bench_dc_dsp(int16_t *x, uint32_t n)
+{
+    static struct dc_block_state st = { .a_q14 = 16255 };
+
+    dc_block_dsp(&st, x, n);
+}
+
+static void bench_agc_dsp(int16_t *x, uint32_t n)
+{
+    agc_ramp_dsp(x, n, 2048, 1);
+}
+#endif
+
+/* Cycles per sample in tenths, one kernel over CONFIG_PDM_BENCH_BLOCKS blocks */
+static uint32_t bench_level_kernel(bench_level_fn fn, int16_t *buf, uint32_t n)
+{
+    const int blocks = CONFIG_PDM_BENCH_BLOCKS;
+    uint32_t lfsr = 0xACE1u;
+    uint64_t ns = 0;
+
+    for (int i = 0; i < blocks; i++) {
+        bench_fill(buf, n, &lfsr);
+
+        uint64_t t0 = bench_now_ns();
+        fn(buf, n);
+        ns += bench_now_ns() - t0;
+    }
+    return (uint32_t)(ns * sys_clock_hw_cycles_per_sec() * 10u /
+                      (1000000000ull * (uint64_t)blocks * n));
+}
+
+/* DC blocker and AGC gain ramp, per sample, C and (if built) DSP kernels */
+static void bench_level(struct k_mem_slab *slab, size_t block_bytes)
+{
+    const uint32_t n = block_bytes / sizeof(int16_t);
+    uint32_t dc, agc;
+    void *buf;
+
+    k_mem_slab_alloc(slab, &buf, K_FOREVER);
+
+    printk("\n");
+    dc = bench_level_kernel(bench_dc_c, buf, n);
+    agc = bench_level_kernel(bench_agc_c, buf, n);
+    printk("bench level c  : dc block %u.%u, agc gain %u.%u cycles/sample\n",
+           dc / 10, dc % 10, agc / 10, agc % 10);
+#if PDM_SIMD
+    dc = bench_level_kernel(bench_dc_dsp, buf, n);
+    agc = bench_level_kernel(bench_agc_dsp, buf, n);
+    printk("bench level dsp: dc block %u.%u, agc gain %u.%u cycles/sample\n",
+           dc / 10, dc % 10, agc / 10, agc % 10);
+#endif
+    k_mem_slab_free(slab, buf);
+}
+#endif
+
+#if defined(CONFIG_PDM_DECIM)
+#if PDM_SIMD
+/* Dot product over random windows, C vs DSP: cycles per output and agreement */
+static void bench_decim_kernels(const int16_t *x, uint32_t n)
+{
+    static int16_t h[64] __aligned(4);
+    const uint32_t outputs = n - ARRAY_SIZE(h);
+    uint32_t lfsr = 0x1D2Bu;
+    uint32_t t0, c_cyc, dsp_cyc;
+    int32_t sum_c = 0, sum_dsp = 0;
+
+    /* sum(|h|) < 2^16 like the generated taps */
+    bench_fill(h, ARRAY_SIZE(h), &lfsr);
+    for (size_t i = 0; i < ARRAY_SIZE(h); i++) {
+        h[i] >>= 6;
+    }
+
+    t0 = k_cycle_get_32();
+    for (uint32_t i = 0; i < outputs; i++) {
+        sum_c += decim_dot_c(&x[i], h, ARRAY_SIZE(h));
+    }
+    c_cyc = k_cycle_get_32() - t0;
+
+    t0 = k_cycle_get_32();
+    for (uint32_t i = 0; i < outputs; i++) {
+        sum_dsp += decim_dot_dsp(&x[i], h, ARRAY_SIZE(h));
+    }
+    dsp_cyc = k_cycle_get_32() - t0;
+
+    printk("bench decim kernels: c %u, dsp %u cycles per %u tap output, results %s\n",
+           c_cyc / outputs, dsp_cyc / outputs, (unsigned)ARRAY_SIZE(h),
+           sum_c == sum_dsp ? "identical" : "DIFFER");
+}
+#endif
+
+/* Decimator cost per block: a capture block in, a stream block (and its half-rate copy) out */
+static void bench_decim(struct k_mem_slab *slab, size_t block_bytes)
+{
+    const int blocks = CONFIG_PDM_BENCH_BLOCKS;
+    const struct pdm_stream_cfg *c = pdm_stream_cfg_get();
+    const uint32_t frames = block_bytes * DECIM_FACTOR / sizeof(int16_t);
+    uint32_t lfsr = 0xACE1u;
+    uint64_t ns = 0;
+    void *buf;
+
+    k_mem_slab_alloc(slab, &buf, K_FOREVER);
+    decim_reset();
+
+    /* slab blocks have room for the half-rate copy past the capture block */
+    int16_t *half = (int16_t *)((uint8_t *)buf + block_bytes * DECIM_FACTOR);
+
+    for (int i = 0; i < blocks; i++) {
+        bench_fill(buf, frames, &lfsr);
+
+        uint64_t t0 = bench_now_ns();
+        uint32_t out = decim_block(buf, frames, 1);
+
+        decim_half(buf, out, 1, half);
+        ns += bench_now_ns() - t0;
+    }
+
+    uint64_t block_ns = ns / blocks;
+    uint32_t permille = (uint32_t)(block_ns * 1000u / ((uint64_t)c->block_ms * 1000000u));
+
+    printk("\nbench decim: %u:1%s, %llu ns/block (%llu cycles), %u.%u%% of the %u ms block budget, %s kernels\n",
+           DECIM_FACTOR, IS_ENABLED(CONFIG_PDM_DECIM_HALF_RATE) ? " + half rate" : "",
+           block_ns, block_ns * sys_clock_hw_cycles_per_sec() / 1000000000u,
+           permille / 10, permille % 10, c->block_ms, PDM_SIMD ? "dsp" : "c");
+#if PDM_SIMD
+    bench_fill(buf, frames, &lfsr);
+    bench_decim_kernels(buf, frames);
+#endif
+    k_mem_slab_free(slab, buf);
+}
+#endif
+
+void bench_run(struct k_mem_slab *slab, size_t block_bytes, bench_feed_fn feed)
+{
+    enum tlv_link_mode mode = tlv_link_get_mode();
+
+    bench_codec(slab, block_bytes);
+#if defined(CONFIG_PDM_DECIM)
+    bench_decim(slab, block_bytes);
+#endif
+#if defined(CONFIG_PDM_NS)
+    bench_ns(slab, block_bytes);
+#endif
+#if defined(CONFIG_PDM_LEVEL)
+    bench_level(slab, block_bytes);
+#endif
+
+    bench_tx_mode(TLV_LINK_MODE_POLL, slab, block_bytes, feed);
+    bench_tx_mode(TLV_LINK_MODE_ASYNC, slab, block_bytes, feed);
+
+    tlv_link_set_mode(mode);
+    printk("bench done\n");
+}
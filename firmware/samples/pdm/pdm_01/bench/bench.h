@@ -0,0 +1,31 @@
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Hands one filled slab block to the pipeline (in place of dmic_read) */
+typedef int (*bench_feed_fn)(void *buf, size_t size);
+
+/*
+ * Pipeline benchmarks (CONFIG_PDM_BENCH). Runs in place of the DMIC, so it
+ * works on native_sim / qemu. Results are printed with printk.
+ */
+void bench_run(struct k_mem_slab *slab, size_t block_bytes, bench_feed_fn feed);
+
+/* Benchmark clock: the host clock on native_sim, the cycle counter elsewhere */
+uint64_t bench_now_ns(void);
+
+/* TX thread: ns it spent sending one batch, waits for blocks and jobs left out */
+void bench_tx_busy(uint64_t ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_H_
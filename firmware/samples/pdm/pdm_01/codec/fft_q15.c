@@ -0,0 +1,156 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <math.h>
+#include "fft_q15.h"
+
+#define TWO_PI  6.283185307f
+
+/* log2(1 + i / 32), Q8 */
+static const uint8_t log2_frac_q8[32] = {
+    0, 11, 22, 33, 44, 54, 63, 73, 82, 92, 100, 109, 118, 126, 134, 142,
+    150, 157, 165, 172, 179, 186, 193, 200, 207, 213, 220, 226, 232, 238, 244, 250,
+};
+
+int32_t fft_q15_log2_q8(uint64_t p)
+{
+    int msb = 63 - __builtin_clzll(p);
+    uint32_t frac = msb >= 5 ? (uint32_t)(p >> (msb - 5)) : (uint32_t)(p << (5 - msb));
+
+    return msb * 256 + log2_frac_q8[frac & 31];
+}
+
+int fft_q15_block_scale(int16_t *x, uint16_t n)
+{
+    int32_t peak = 0;
+
+    for (uint16_t i = 0; i < n; i++) {
+        int32_t v = x[i] < 0 ? -x[i] : x[i];
+
+        peak = v > peak ? v : peak;
+    }
+
+    int shift = 0;
+
+    if (peak >= (1 << 14)) {
+        shift = -1;
+    } else if (peak > 0) {
+        while ((peak << (shift + 1)) < (1 << 14)) {
+            shift++;
+        }
+    }
+    for (uint16_t i = 0; i < n && shift != 0; i++) {
+        x[i] = shift > 0 ? (int16_t)(x[i] << shift) : (int16_t)(x[i] >> 1);
+    }
+    return shift;
+}
+
+static inline int16_t sat16(int32_t v)
+{
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+}
+
+int fft_q15_init(struct fft_q15 *f, uint16_t n)
+{
+    if (n < FFT_Q15_MIN || n > FFT_Q15_MAX || (n & (n - 1)) != 0) {
+        return -EINVAL;
+    }
+#if defined(CONFIG_PDM_FFT_CMSIS_DSP)
+    if (arm_rfft_init_q15(&f->rfft, n, 0, 1) != ARM_MATH_SUCCESS) {
+        return -EINVAL;
+    }
+#endif
+    f->n = n;
+    for (uint16_t k = 0; k < n / 2; k++) {
+        f->cos_q15[k] = (int16_t)lroundf(32767.0f * cosf(TWO_PI * k / n));
+        f->sin_q15[k] = (int16_t)lroundf(32767.0f * sinf(TWO_PI * k / n));
+    }
+    return 0;
+}
+
+/*
+ * In place complex radix-2 FFT of n points, re/im interleaved. Stages
+ * whose bit is set in halve_mask (bit s: the stage combining 2^(s+1)
+ * points) halve their output, rounded (truncation noise piles up over
+ * 9 stages).
+ */
+static void cfft_q15(const struct fft_q15 *f, int16_t *x, uint16_t halve_mask)
+{
+    const uint16_t n = f->n;
+
+    for (uint16_t i = 1, j = 0; i < n; i++) {
+        uint16_t bit = n >> 1;
+
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            int16_t t;
+
+            t = x[2 * i]; x[2 * i] = x[2 * j]; x[2 * j] = t;
+            t = x[2 * i + 1]; x[2 * i + 1] = x[2 * j + 1]; x[2 * j + 1] = t;
+        }
+    }
+
+    for (uint16_t len = 2, s = 0; len <= n; len <<= 1, s++) {
+        const uint16_t half = len / 2;
+        const uint16_t step = n / len;
+        const int sh = (halve_mask >> s) & 1;
+
+        for (uint16_t i = 0; i < n; i += len) {
+            for (uint16_t k = 0; k < half; k++) {
+                int16_t *a = &x[2 * (i + k)];
+                int16_t *b = &x[2 * (i + k + half)];
+                int32_t wr = f->cos_q15[k * step];
+                int32_t wi = -f->sin_q15[k * step];
+                int32_t tr = (b[0] * wr - b[1] * wi + (1 << 14)) >> 15;
+                int32_t ti = (b[0] * wi + b[1] * wr + (1 << 14)) >> 15;
+                int32_t ar = a[0];
+                int32_t ai = a[1];
+
+                a[0] = sat16((ar + tr + sh) >> sh);
+                a[1] = sat16((ai + ti + sh) >> sh);
+                b[0] = sat16((ar - tr + sh) >> sh);
+                b[1] = sat16((ai - ti + sh) >> sh);
+            }
+        }
+    }
+}
+
+void fft_q15_real(struct fft_q15 *f, int16_t *in, int16_t *out)
+{
+#if defined(CONFIG_PDM_FFT_CMSIS_DSP)
+    arm_rfft_q15(&f->rfft, in, out);
+#else
+    for (uint16_t i = 0; i < f->n; i++) {
+        out[2 * i] = in[i];
+        out[2 * i + 1] = 0;
+    }
+    /* every stage but the last: X / (N / 2) like arm_rfft_q15() */
+    cfft_q15(f, out, (f->n >> 1) - 1);
+#endif
+}
+
+/*
+ * conj(FFT(conj(X))) = N * IFFT(X). X is the forward output X' / (N / 2),
+ * so halving once (first stage, where values are smallest relative to
+ * the headroom) gives back the input scale. The real part needs no conj.
+ */
+void fft_q15_real_inverse(const struct fft_q15 *f, int16_t *spec, int16_t *out)
+{
+    const uint16_t n = f->n;
+
+    for (uint16_t k = 1; k < n / 2; k++) {
+        spec[2 * (n - k)] = spec[2 * k];
+        spec[2 * (n - k) + 1] = spec[2 * k + 1];
+    }
+    /* X[n - k] = conj(X[k]), then conj of the whole: only k <= n / 2 flips */
+    for (uint16_t k = 0; k <= n / 2; k++) {
+        spec[2 * k + 1] = (int16_t)-spec[2 * k + 1];
+    }
+    cfft_q15(f, spec, 1);
+    for (uint16_t i = 0; i < n; i++) {
+        out[i] = spec[2 * i];
+    }
+}
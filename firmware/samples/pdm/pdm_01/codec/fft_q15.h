@@ -0,0 +1,68 @@
+#ifndef FFT_Q15_H_
+#define FFT_Q15_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(CONFIG_PDM_FFT_CMSIS_DSP)
+#include <arm_math.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Real Q15 FFT shared by the spectral stages (spectrum and MFCC codecs,
+ * noise suppression). The forward transform is arm_rfft_q15() from
+ * CMSIS-DSP with CONFIG_PDM_FFT_CMSIS_DSP, otherwise a portable radix-2 FFT
+ * with the same output scaling. The inverse is always the portable one:
+ * arm_rfft_q15() scales its inverse by 1 / N, 9 bits lost at N = 512.
+ */
+#define FFT_Q15_MIN     64
+#define FFT_Q15_MAX     512
+
+/* FFT peak bin of a full-scale sine, (32768 * N / 4) / (N / 2) = 2^14: power 2^28 */
+#define FFT_Q15_P0_LOG2 28
+
+struct fft_q15 {
+    uint16_t n;
+#if defined(CONFIG_PDM_FFT_CMSIS_DSP)
+    arm_rfft_instance_q15 rfft;
+#endif
+    int16_t  cos_q15[FFT_Q15_MAX / 2];
+    int16_t  sin_q15[FFT_Q15_MAX / 2];
+};
+
+/* n: power of two, FFT_Q15_MIN..FFT_Q15_MAX. Returns 0 or -EINVAL. */
+int      fft_q15_init(struct fft_q15 *f, uint16_t n);
+
+/*
+ * in: n real samples, clobbered. out: 2 * n values, re/im interleaved,
+ * X / (n / 2); bins up to n / 2 are meaningful. Input magnitudes must stay
+ * below 2^14, see fft_q15_block_scale().
+ */
+void     fft_q15_real(struct fft_q15 *f, int16_t *in, int16_t *out);
+
+/*
+ * Inverse of fft_q15_real(): spec holds bins 0..n / 2 (re, im interleaved,
+ * the X / (n / 2) scaling of the forward transform) and is clobbered, all
+ * 2 * n values. out gets the n real samples at the forward input's scale.
+ */
+void     fft_q15_real_inverse(const struct fft_q15 *f, int16_t *spec, int16_t *out);
+
+/*
+ * Block floating point: scales x in place so its peak is 2^13..2^14 and
+ * returns the shift applied (-1..15, 0 for silence). Powers computed from
+ * the FFT of the scaled input are 2^(2 * shift) too large.
+ */
+int      fft_q15_block_scale(int16_t *x, uint16_t n);
+
+/* log2(p) in Q8 (about 0.02 resolution), p > 0 */
+int32_t  fft_q15_log2_q8(uint64_t p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FFT_Q15_H_
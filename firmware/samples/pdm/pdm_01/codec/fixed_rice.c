@@ -0,0 +1,173 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "fixed_rice.h"
+
+#define RICE_MAX_K  15
+
+struct bit_writer {
+    uint8_t *p;
+    uint32_t acc;     /* pending bits, MSB aligned at bit (nbits - 1) */
+    uint8_t  nbits;
+};
+
+static inline void bw_put(struct bit_writer *bw, uint32_t v, uint8_t n)
+{
+    /* n <= 24 so acc never overflows */
+    bw->acc = (bw->acc << n) | (v & ((1u << n) - 1u));
+    bw->nbits += n;
+    while (bw->nbits >= 8) {
+        bw->nbits -= 8;
+        *bw->p++ = (uint8_t)(bw->acc >> bw->nbits);
+    }
+}
+
+static inline void bw_zeros(struct bit_writer *bw, uint32_t n)
+{
+    while (n > 16) {
+        bw_put(bw, 0, 16);
+        n -= 16;
+    }
+    bw_put(bw, 0, (uint8_t)n);
+}
+
+static inline void bw_flush(struct bit_writer *bw)
+{
+    if (bw->nbits) {
+        *bw->p++ = (uint8_t)(bw->acc << (8 - bw->nbits));
+        bw->nbits = 0;
+    }
+}
+
+static inline uint32_t zigzag(int32_t r)
+{
+    return ((uint32_t)r << 1) ^ (uint32_t)(r >> 31);
+}
+
+static inline int32_t fixed_residual(const int16_t *x, size_t i, unsigned int order)
+{
+    switch (order) {
+    case 0:
+        return x[i];
+    case 1:
+        return x[i] - x[i - 1];
+    case 2:
+        return x[i] - 2 * x[i - 1] + x[i - 2];
+    case 3:
+        return x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+    default:
+        return x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4];
+    }
+}
+
+/* Order with the smallest sum of |residual| (FLAC's fixed predictor search) */
+static unsigned int pick_order(const int16_t *x, size_t n)
+{
+    uint32_t sum[FIXED_RICE_MAX_ORDER + 1] = { 0 };
+
+    for (size_t i = FIXED_RICE_MAX_ORDER; i < n; i++) {
+        int32_t e0 = x[i];
+        int32_t e1 = e0 - x[i - 1];
+        int32_t e2 = e1 - (x[i - 1] - x[i - 2]);
+        int32_t e3 = e2 - (x[i - 1] - 2 * x[i - 2] + x[i - 3]);
+        int32_t e4 = e3 - (x[i - 1] - 3 * x[i - 2] + 3 * x[i - 3] - x[i - 4]);
+
+        sum[0] += (uint32_t)(e0 < 0 ? -e0 : e0);
+        sum[1] += (uint32_t)(e1 < 0 ? -e1 : e1);
+        sum[2] += (uint32_t)(e2 < 0 ? -e2 : e2);
+        sum[3] += (uint32_t)(e3 < 0 ? -e3 : e3);
+        sum[4] += (uint32_t)(e4 < 0 ? -e4 : e4);
+    }
+
+    unsigned int best = 0;
+    for (unsigned int o = 1; o <= FIXED_RICE_MAX_ORDER; o++) {
+        if (sum[o] < sum[best]) {
+            best = o;
+        }
+    }
+    return best;
+}
+
+static size_t encode_verbatim(const int16_t *in, size_t n, uint8_t *out)
+{
+    size_t len = FIXED_RICE_MAX_BYTES(n);
+
+    out[0] = (uint8_t)(len & 0xFF);
+    out[1] = (uint8_t)(len >> 8);
+    out[2] = FIXED_RICE_VERBATIM;
+    out[3] = 0;
+    for (size_t i = 0; i < n; i++) {
+        out[FIXED_RICE_HDR_BYTES + 2 * i]     = (uint8_t)((uint16_t)in[i] & 0xFF);
+        out[FIXED_RICE_HDR_BYTES + 2 * i + 1] = (uint8_t)((uint16_t)in[i] >> 8);
+    }
+    return len;
+}
+
+size_t fixed_rice_encode_block(const int16_t *in, size_t n, uint8_t *out)
+{
+    if (n <= FIXED_RICE_MAX_ORDER) {
+        return encode_verbatim(in, n, out);
+    }
+
+    const unsigned int order = pick_order(in, n);
+    const size_t n_res = n - order;
+
+    /* Rice parameter from the mean, then the exact cost of k-1, k, k+1 */
+    uint32_t sum_u = 0;
+    for (size_t i = order; i < n; i++) {
+        sum_u += zigzag(fixed_residual(in, i, order));
+    }
+
+    unsigned int k0 = 0;
+    while (k0 < RICE_MAX_K && ((uint32_t)n_res << (k0 + 1)) < sum_u) {
+        k0++;
+    }
+    unsigned int k_lo = (k0 > 0) ? k0 - 1 : 0;
+    unsigned int k_hi = (k0 < RICE_MAX_K) ? k0 + 1 : RICE_MAX_K;
+
+    uint32_t bits[3] = { 0 };
+    for (size_t i = order; i < n; i++) {
+        uint32_t u = zigzag(fixed_residual(in, i, order));
+
+        for (unsigned int k = k_lo; k <= k_hi; k++) {
+            bits[k - k_lo] += (u >> k) + 1 + k;
+        }
+    }
+
+    unsigned int k = k_lo;
+    for (unsigned int c = k_lo + 1; c <= k_hi; c++) {
+        if (bits[c - k_lo] < bits[k - k_lo]) {
+            k = c;
+        }
+    }
+
+    size_t len = FIXED_RICE_HDR_BYTES + 2 * order + (bits[k - k_lo] + 7) / 8;
+    if (len >= FIXED_RICE_MAX_BYTES(n)) {
+        return encode_verbatim(in, n, out);
+    }
+
+    out[0] = (uint8_t)(len & 0xFF);
+    out[1] = (uint8_t)(len >> 8);
+    out[2] = (uint8_t)order;
+    out[3] = (uint8_t)k;
+
+    uint8_t *p = &out[FIXED_RICE_HDR_BYTES];
+    for (unsigned int i = 0; i < order; i++) {
+        *p++ = (uint8_t)((uint16_t)in[i] & 0xFF);
+        *p++ = (uint8_t)((uint16_t)in[i] >> 8);
+    }
+
+    struct bit_writer bw = { .p = p, .acc = 0, .nbits = 0 };
+    for (size_t i = order; i < n; i++) {
+        uint32_t u = zigzag(fixed_residual(in, i, order));
+
+        bw_zeros(&bw, u >> k);
+        bw_put(&bw, 1, 1);
+        if (k) {
+            bw_put(&bw, u, (uint8_t)k);
+        }
+    }
+    bw_flush(&bw);
+
+    return len;
+}
@@ -0,0 +1,31 @@
+#ifndef FIXED_RICE_H_
+#define FIXED_RICE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Lossless block, FLAC style: fixed polynomial predictor + Rice residuals.
+ *   len(u16 LE, whole block incl. this header), order(u8), rice_k(u8)
+ *   order 0..4 : order warm-up samples (i16 LE), then (n - order) Rice
+ *                codes MSB first: q zero bits, a one bit, k low bits of
+ *                the zigzag residual; zero padded to a byte
+ *   order 0xFF : n raw samples (i16 LE), used when coding does not pay
+ */
+#define FIXED_RICE_HDR_BYTES       4
+#define FIXED_RICE_MAX_ORDER       4
+#define FIXED_RICE_VERBATIM        0xFF
+#define FIXED_RICE_MAX_BYTES(n)    (FIXED_RICE_HDR_BYTES + 2 * (n))
+
+/* Encodes n samples into out (FIXED_RICE_MAX_BYTES(n)), returns bytes written */
+size_t fixed_rice_encode_block(const int16_t *in, size_t n, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXED_RICE_H_
@@ -0,0 +1,120 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "ima_adpcm.h"
+
+static const int16_t step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static inline uint8_t encode_sample(struct ima_adpcm_state *st, int16_t s)
+{
+    int32_t step  = step_table[st->step_index];
+    int32_t diff  = (int32_t)s - st->predictor;
+    int32_t vpdiff = step >> 3;
+    uint8_t code = 0;
+
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        vpdiff += step;
+    }
+
+    int32_t pred = st->predictor + ((code & 8) ? -vpdiff : vpdiff);
+    if (pred > INT16_MAX) {
+        pred = INT16_MAX;
+    } else if (pred < INT16_MIN) {
+        pred = INT16_MIN;
+    }
+    st->predictor = (int16_t)pred;
+
+    int idx = st->step_index + index_table[code];
+    if (idx < 0) {
+        idx = 0;
+    } else if (idx > 88) {
+        idx = 88;
+    }
+    st->step_index = (uint8_t)idx;
+
+    return code;
+}
+
+void ima_adpcm_reset(struct ima_adpcm_state *st)
+{
+    st->predictor = 0;
+    st->step_index = 0;
+}
+
+size_t ima_adpcm_encode_block(struct ima_adpcm_state *st, const int16_t *in,
+                              size_t n, uint8_t *out)
+{
+    if (n == 0) {
+        return 0;
+    }
+
+    /*
+     * out may alias in (encode in place): the header overwrites in[1], so
+     * the first code byte (in[1], in[2]) is produced before it is written.
+     * After that, code byte k lands well below the next unread sample.
+     */
+    const int16_t first = in[0];
+    const uint8_t step_index = st->step_index;
+    uint8_t first_byte = 0;
+    size_t i = 1;
+
+    /* Block restarts from its first sample; the step index carries over */
+    st->predictor = first;
+    if (n > 2) {
+        first_byte = encode_sample(st, in[1]);
+        first_byte |= (uint8_t)(encode_sample(st, in[2]) << 4);
+        i = 3;
+    } else if (n == 2) {
+        first_byte = encode_sample(st, in[1]);
+        i = 2;
+    }
+
+    out[0] = (uint8_t)((uint16_t)first & 0xFF);
+    out[1] = (uint8_t)((uint16_t)first >> 8);
+    out[2] = step_index;
+    out[3] = 0;
+
+    uint8_t *p = &out[IMA_ADPCM_HDR_BYTES];
+    if (n > 1) {
+        *p++ = first_byte;
+    }
+
+    for (; i + 1 < n; i += 2) {
+        uint8_t lo = encode_sample(st, in[i]);
+        uint8_t hi = encode_sample(st, in[i + 1]);
+        *p++ = (uint8_t)(lo | (hi << 4));
+    }
+    if (i < n) {
+        *p++ = encode_sample(st, in[i]);
+    }
+
+    return (size_t)(p - out);
+}
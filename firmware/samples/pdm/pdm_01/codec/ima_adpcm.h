@@ -0,0 +1,40 @@
+#ifndef IMA_ADPCM_H_
+#define IMA_ADPCM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * IMA-ADPCM block:
+ *   predictor(i16 LE) = first sample, step_index(u8), reserved(u8)
+ *   + (n - 1) 4-bit codes, low nibble first, last byte zero padded
+ *
+ * Every block carries the encoder state it starts from, so it decodes on
+ * its own: a lost block never corrupts the ones after it.
+ */
+#define IMA_ADPCM_HDR_BYTES        4
+#define IMA_ADPCM_BLOCK_BYTES(n)   (IMA_ADPCM_HDR_BYTES + ((n) / 2))
+
+struct ima_adpcm_state {
+    int16_t predictor;
+    uint8_t step_index;
+};
+
+void   ima_adpcm_reset(struct ima_adpcm_state *st);
+
+/*
+ * Encodes n samples into out (IMA_ADPCM_BLOCK_BYTES(n)), returns bytes
+ * written. out may point at in to encode in place.
+ */
+size_t ima_adpcm_encode_block(struct ima_adpcm_state *st, const int16_t *in,
+                              size_t n, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IMA_ADPCM_H_
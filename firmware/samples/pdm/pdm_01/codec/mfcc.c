@@ -0,0 +1,109 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+#include "mfcc.h"
+#include "mfcc_tables.h"
+
+BUILD_ASSERT(MFCC_TABLES_FRAME_LEN == MFCC_FRAME_LEN && MFCC_TABLES_FFT_SIZE == MFCC_FFT_SIZE &&
+             MFCC_TABLES_MELS == MFCC_MELS && MFCC_TABLES_COEFS == MFCC_COEFS,
+             "mfcc_tables.h is stale, rebuild from scratch");
+BUILD_ASSERT(MFCC_HOP <= MFCC_FRAME_LEN, "PDM_MFCC_HOP longer than the frame");
+
+/* CONFIG_PDM_MFCC_PREEMPH percent, Q15 */
+#define PREEMPH_Q15  MIN(CONFIG_PDM_MFCC_PREEMPH * 32768 / 100, 32767)
+
+/*
+ * log2 of band energy that puts 0 at a full-scale sine in one bin: FFT
+ * power (FFT_Q15_P0_LOG2), Q15 filterbank weight, less the 2 for the
+ * halved pre-emphasis output.
+ */
+#define LOG2_REF  (FFT_Q15_P0_LOG2 + 15 - 2)
+
+void mfcc_reset(struct mfcc_state *st)
+{
+    memset(st->hist, 0, sizeof(st->hist));
+    st->prev = 0;
+    st->phase = 0;
+    fft_q15_init(&st->fftq, MFCC_FFT_SIZE);
+}
+
+static void mfcc_vector(struct mfcc_state *st, uint8_t *out)
+{
+    for (uint16_t i = 0; i < MFCC_FRAME_LEN; i++) {
+        st->frame[i] = (int16_t)((st->hist[i] * mfcc_window_q15[i] + (1 << 14)) >> 15);
+    }
+    memset(&st->frame[MFCC_FRAME_LEN], 0, (MFCC_FFT_SIZE - MFCC_FRAME_LEN) * sizeof(int16_t));
+
+    const int shift = fft_q15_block_scale(st->frame, MFCC_FRAME_LEN);
+
+    fft_q15_real(&st->fftq, st->frame, st->fft);
+
+    for (uint16_t m = 0; m < MFCC_MELS; m++) {
+        const int16_t *w = &mfcc_mel_w_q15[mfcc_mel_off[m]];
+        const int16_t *x = &st->fft[2 * mfcc_mel_first[m]];
+        uint64_t e = 0;
+
+        for (uint16_t j = 0; j < mfcc_mel_count[m]; j++, x += 2) {
+            uint32_t p = (uint32_t)(x[0] * x[0]) + (uint32_t)(x[1] * x[1]);
+
+            e += (uint64_t)p * (uint16_t)w[j];
+        }
+
+        int32_t l = e ? fft_q15_log2_q8(e) - ((LOG2_REF + 2 * shift) << 8) : MFCC_LOG2_FLOOR_Q8;
+
+        st->log_mel[m] = MAX(l, MFCC_LOG2_FLOOR_Q8);
+    }
+
+    /* Q8 log2 x Q15 (DCT with ln 2 folded in) = Q23 -> Q7 */
+    const int16_t *d = mfcc_dct_q15;
+
+    for (uint16_t c = 0; c < MFCC_COEFS; c++) {
+        int64_t acc = 0;
+
+        for (uint16_t m = 0; m < MFCC_MELS; m++) {
+            acc += (int64_t)*d++ * st->log_mel[m];
+        }
+        acc = (acc + (1 << 15)) >> 16;
+        sys_put_le16((uint16_t)(int16_t)CLAMP(acc, INT16_MIN, INT16_MAX), &out[2 * c]);
+    }
+}
+
+size_t mfcc_encode_block(struct mfcc_state *st, const int16_t *in, size_t n, uint8_t *out)
+{
+    uint8_t *p = out + MFCC_HDR_BYTES;
+    uint8_t count = 0;
+    uint16_t first_end = 0;
+
+    for (size_t i = 0; i < n;) {
+        const uint16_t take = (uint16_t)MIN(n - i, (size_t)(MFCC_HOP - st->phase));
+        int16_t *h = &st->hist[MFCC_FRAME_LEN - take];
+
+        memmove(st->hist, &st->hist[take], (MFCC_FRAME_LEN - take) * sizeof(int16_t));
+
+        /* y = (x - a * x[-1]) / 2: can't overflow int16 */
+        for (uint16_t j = 0; j < take; j++) {
+            int32_t x = in[i + j];
+
+            h[j] = (int16_t)((x * 32768 - PREEMPH_Q15 * st->prev) >> 16);
+            st->prev = (int16_t)x;
+        }
+        i += take;
+        st->phase += take;
+
+        if (st->phase == MFCC_HOP) {
+            st->phase = 0;
+            if (count == 0) {
+                first_end = (uint16_t)i;
+            }
+            mfcc_vector(st, p);
+            p += MFCC_COEFS * 2;
+            count++;
+        }
+    }
+
+    out[0] = count;
+    out[1] = MFCC_COEFS;
+    sys_put_le16(MFCC_HOP, &out[2]);
+    sys_put_le16(first_end, &out[4]);
+    return (size_t)(p - out);
+}
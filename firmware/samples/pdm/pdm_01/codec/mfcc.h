@@ -0,0 +1,70 @@
+#ifndef MFCC_H_
+#define MFCC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "fft_q15.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * MFCC feature vectors (CONFIG_PDM_CODEC_MFCC), one per CONFIG_PDM_MFCC_HOP
+ * samples: pre-emphasis, Hamming window over the newest
+ * CONFIG_PDM_MFCC_FRAME_LEN samples (zero padded to the FFT size), Q15 FFT,
+ * mel filterbank, log2 in Q8, DCT-II. Window, filterbank and DCT are
+ * tables generated at build time (codec/mfcc_tables.py).
+ *
+ * Encoded block:
+ *   count(u8), coefs(u8), hop(u16 LE), first_end(u16 LE)
+ *   + count * coefs int16 LE, Q7 (value / 128)
+ * Vector i is computed from the frame ending first_end + i * hop samples
+ * into the block (first_end = 0 when count = 0). The frame history runs
+ * on across blocks, so a block shorter than the hop can carry no vector.
+ *
+ * Coefficients are the orthonormal DCT of the natural log of the mel band
+ * energies, with 0 at the power of a full-scale sine in one FFT bin; band
+ * energies below MFCC_LOG2_FLOOR_Q8 are clamped (silence stays finite).
+ * The Q15 FFT resolves about 90 dB within one frame: bands further below
+ * the loudest one read high (pure tones over a silent background).
+ */
+#define MFCC_FRAME_LEN      CONFIG_PDM_MFCC_FRAME_LEN
+#define MFCC_FFT_SIZE       (MFCC_FRAME_LEN <= 64 ? 64 : MFCC_FRAME_LEN <= 128 ? 128 : \
+                             MFCC_FRAME_LEN <= 256 ? 256 : 512)
+#define MFCC_HOP            CONFIG_PDM_MFCC_HOP
+#define MFCC_MELS           CONFIG_PDM_MFCC_MELS
+#define MFCC_COEFS          CONFIG_PDM_MFCC_COEFS
+
+#define MFCC_HDR_BYTES      6
+#define MFCC_COEF_FRAC_BITS 7
+#define MFCC_LOG2_FLOOR_Q8  (-40 * 256)   /* about -120 dB */
+
+/* Largest encoding of n samples */
+#define MFCC_MAX_BYTES(n)   (MFCC_HDR_BYTES + ((n) / MFCC_HOP + 1) * MFCC_COEFS * 2)
+
+struct mfcc_state {
+    int16_t  hist[MFCC_FRAME_LEN];      /* pre-emphasised, halved, newest last */
+    int16_t  prev;                      /* last input sample, for the pre-emphasis */
+    uint16_t phase;                     /* samples since the last vector */
+    int16_t  frame[MFCC_FFT_SIZE];      /* windowed input, clobbered by the FFT */
+    int16_t  fft[2 * MFCC_FFT_SIZE];
+    int32_t  log_mel[MFCC_MELS];        /* log2 band energies, Q8 */
+    struct fft_q15 fftq;
+};
+
+/* Call before the first block of a stream (also after a restart) */
+void   mfcc_reset(struct mfcc_state *st);
+
+/*
+ * Feeds n mono samples, writes the encoded block (at most MFCC_MAX_BYTES(n))
+ * to out and returns its length. out must not overlap in: vectors can be
+ * due before the samples they sit on in the block have been read.
+ */
+size_t mfcc_encode_block(struct mfcc_state *st, const int16_t *in, size_t n, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MFCC_H_
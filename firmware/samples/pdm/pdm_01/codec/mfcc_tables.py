@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+Generates mfcc_tables.h for codec/mfcc.c at build time (CMakeLists.txt runs
+it with the CONFIG_PDM_MFCC_* values):
+
+  mfcc_window_q15    Hamming window, frame_len taps
+  mfcc_mel_*         HTK mel filterbank, triangles sampled at the FFT bins,
+                     stored sparse (first bin, bin count, offset into the
+                     weights) with Q15 weights
+  mfcc_dct_q15       orthonormal DCT-II, coefs x mels, with ln(2) folded in
+                     so it maps log2 mel energies straight to natural-log
+                     cepstra
+
+Standard library only: it runs under the Python the Zephyr build uses.
+"""
+import argparse
+import math
+
+
+def hz_to_mel(f: float) -> float:
+    return 2595.0 * math.log10(1.0 + f / 700.0)
+
+
+def mel_to_hz(m: float) -> float:
+    return 700.0 * (10.0 ** (m / 2595.0) - 1.0)
+
+
+def q15(x: float) -> int:
+    return max(-32768, min(32767, int(round(x * 32768.0))))
+
+
+def mel_filters(rate, fft_size, mels, fmin, fmax):
+    """[(first_bin, [weights...])] per mel band, every band at least one bin."""
+    lo, hi = hz_to_mel(fmin), hz_to_mel(fmax)
+    pts = [mel_to_hz(lo + (hi - lo) * i / (mels + 1)) for i in range(mels + 2)]
+    bin_hz = rate / fft_size
+    out = []
+    for m in range(mels):
+        left, centre, right = pts[m], pts[m + 1], pts[m + 2]
+        w = {}
+        for k in range(1, fft_size // 2 + 1):
+            f = k * bin_hz
+            if left < f < right:
+                w[k] = (f - left) / (centre - left) if f <= centre else (right - f) / (right - centre)
+        if not any(q15(v) for v in w.values()):
+            # narrower than a bin (low bands, short FFTs): take the nearest bin
+            w = {max(1, min(fft_size // 2, int(round(centre / bin_hz)))): 1.0}
+        ks = sorted(k for k, v in w.items() if q15(v) > 0)
+        out.append((ks[0], [q15(w.get(k, 0.0)) for k in range(ks[0], ks[-1] + 1)]))
+    return out
+
+
+def c_array(ctype, name, values, per_line=12):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("    " + ", ".join(str(v) for v in values[i:i + per_line]) + ",")
+    return f"static const {ctype} {name}[{len(values)}] = {{\n" + "\n".join(lines) + "\n};\n"
+
+
+def main() -> None:
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--rate", type=int, required=True)
+    ap.add_argument("--frame-len", type=int, required=True)
+    ap.add_argument("--mels", type=int, required=True)
+    ap.add_argument("--coefs", type=int, required=True)
+    ap.add_argument("--fmin", type=int, default=20)
+    ap.add_argument("--fmax", type=int, default=0, help="0 = rate / 2")
+    ap.add_argument("-o", "--output", required=True)
+    a = ap.parse_args()
+
+    fft_size = 1 << (a.frame_len - 1).bit_length()
+    fmax = a.fmax or a.rate // 2
+    if not (0 <= a.fmin < fmax <= a.rate // 2):
+        ap.error(f"need 0 <= fmin < fmax <= rate / 2, got {a.fmin}..{fmax}")
+    if not (1 <= a.coefs <= a.mels):
+        ap.error("need 1 <= coefs <= mels")
+
+    window = [q15(0.54 - 0.46 * math.cos(2 * math.pi * i / (a.frame_len - 1))) for i in range(a.frame_len)]
+
+    filters = mel_filters(a.rate, fft_size, a.mels, a.fmin, fmax)
+    first, count, off, weights = [], [], [], []
+    for k0, w in filters:
+        first.append(k0)
+        count.append(len(w))
+        off.append(len(weights))
+        weights.extend(w)
+
+    dct = []
+    for j in range(a.coefs):
+        scale = math.sqrt((1.0 if j == 0 else 2.0) / a.mels) * math.log(2.0)
+        dct.extend(q15(scale * math.cos(math.pi * j * (m + 0.5) / a.mels)) for m in range(a.mels))
+
+    with open(a.output, "w") as f:
+        f.write("/* Generated by codec/mfcc_tables.py, do not edit */\n")
+        f.write("#ifndef MFCC_TABLES_H_\n#define MFCC_TABLES_H_\n\n#include <stdint.h>\n\n")
+        f.write(f"#define MFCC_TABLES_RATE_HZ    {a.rate}\n")
+        f.write(f"#define MFCC_TABLES_FRAME_LEN  {a.frame_len}\n")
+        f.write(f"#define MFCC_TABLES_FFT_SIZE   {fft_size}\n")
+        f.write(f"#define MFCC_TABLES_MELS       {a.mels}\n")
+        f.write(f"#define MFCC_TABLES_COEFS      {a.coefs}\n")
+        f.write(f"#define MFCC_TABLES_FMIN_HZ    {a.fmin}\n")
+        f.write(f"#define MFCC_TABLES_FMAX_HZ    {fmax}\n\n")
+        f.write(c_array("int16_t", "mfcc_window_q15", window))
+        f.write(c_array("uint16_t", "mfcc_mel_first", first))
+        f.write(c_array("uint16_t", "mfcc_mel_count", count))
+        f.write(c_array("uint16_t", "mfcc_mel_off", off))
+        f.write(c_array("int16_t", "mfcc_mel_w_q15", weights))
+        f.write(c_array("int16_t", "mfcc_dct_q15", dct, per_line=a.mels if a.mels <= 16 else 8))
+        f.write("\n#endif // MFCC_TABLES_H_\n")
+
+
+if __name__ == "__main__":
+    main()
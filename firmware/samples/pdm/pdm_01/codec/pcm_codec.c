@@ -0,0 +1,121 @@
+#include <zephyr/kernel.h>
+#include "pcm_codec.h"
+#include "tlv_link.h"
+
+#if defined(CONFIG_PDM_CODEC_ADPCM)
+#include "ima_adpcm.h"
+
+static struct ima_adpcm_state adpcm_st;
+
+uint8_t pcm_codec_tlv_type(void)
+{
+    return TLV_T_ADPCM_BATCH;
+}
+
+void pcm_codec_reset(void)
+{
+    ima_adpcm_reset(&adpcm_st);
+}
+
+const void *pcm_codec_encode(const void *pcm, uint16_t size, void *out, uint16_t *len)
+{
+    *len = (uint16_t)ima_adpcm_encode_block(&adpcm_st, pcm, size / sizeof(int16_t), out);
+    return out;
+}
+
+#elif defined(CONFIG_PDM_CODEC_LOSSLESS)
+#include "pdm_cfg.h"
+#include "fixed_rice.h"
+
+uint8_t pcm_codec_tlv_type(void)
+{
+    return TLV_T_LOSSLESS_BATCH;
+}
+
+void pcm_codec_reset(void)
+{
+}
+
+const void *pcm_codec_encode(const void *pcm, uint16_t size, void *out, uint16_t *len)
+{
+    size_t n = MIN(size / sizeof(int16_t), SAMPLES_PER_BLOCK_MAX);
+
+    *len = (uint16_t)fixed_rice_encode_block(pcm, n, out);
+    return out;
+}
+
+#elif defined(CONFIG_PDM_CODEC_SPECTRUM)
+#include "spectrum.h"
+
+static struct spectrum_state spectrum_st;
+
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_PDM_SPECTRUM_FFT_SIZE) &&
+             CONFIG_PDM_SPECTRUM_FFT_SIZE >= SPECTRUM_FFT_MIN &&
+             CONFIG_PDM_SPECTRUM_FFT_SIZE <= SPECTRUM_FFT_MAX,
+             "PDM_SPECTRUM_FFT_SIZE must be a power of two, 64..512");
+BUILD_ASSERT(CONFIG_PDM_SPECTRUM_BANDS < CONFIG_PDM_SPECTRUM_FFT_SIZE / 2,
+             "more PDM_SPECTRUM_BANDS than FFT bins");
+BUILD_ASSERT(PCM_CODEC_MIN_BLOCK_BYTES == SPECTRUM_FRAME_BYTES(SPECTRUM_LEVELS));
+
+uint8_t pcm_codec_tlv_type(void)
+{
+    return TLV_T_SPECTRUM_BATCH;
+}
+
+void pcm_codec_reset(void)
+{
+    spectrum_init(&spectrum_st, CONFIG_PDM_SPECTRUM_FFT_SIZE, CONFIG_PDM_SPECTRUM_BANDS);
+}
+
+const void *pcm_codec_encode(const void *pcm, uint16_t size, void *out, uint16_t *len)
+{
+    *len = (uint16_t)spectrum_encode_block(&spectrum_st, pcm, size / sizeof(int16_t), out);
+    return out;
+}
+
+#elif defined(CONFIG_PDM_CODEC_MFCC)
+#include "pdm_cfg.h"
+#include "mfcc.h"
+
+static struct mfcc_state mfcc_st;
+
+BUILD_ASSERT(MFCC_HOP >= 2 * MFCC_COEFS, "PDM_MFCC_HOP must be at least 2 * PDM_MFCC_COEFS");
+BUILD_ASSERT(MFCC_COEFS <= MFCC_MELS, "more PDM_MFCC_COEFS than PDM_MFCC_MELS");
+
+uint8_t pcm_codec_tlv_type(void)
+{
+    return TLV_T_MFCC_BATCH;
+}
+
+void pcm_codec_reset(void)
+{
+    mfcc_reset(&mfcc_st);
+}
+
+const void *pcm_codec_encode(const void *pcm, uint16_t size, void *out, uint16_t *len)
+{
+    size_t n = MIN(size / sizeof(int16_t), SAMPLES_PER_BLOCK_MAX);
+
+    *len = (uint16_t)mfcc_encode_block(&mfcc_st, pcm, n, out);
+    return out;
+}
+
+#else /* CONFIG_PDM_CODEC_RAW */
+
+uint8_t pcm_codec_tlv_type(void)
+{
+    return TLV_T_PCM_BATCH;
+}
+
+void pcm_codec_reset(void)
+{
+}
+
+const void *pcm_codec_encode(const void *pcm, uint16_t size, void *out, uint16_t *len)
+{
+    ARG_UNUSED(out);
+    *len = size;
+    return pcm;
+}
+
+#endif
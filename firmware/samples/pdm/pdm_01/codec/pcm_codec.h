@@ -0,0 +1,70 @@
+#ifndef PCM_CODEC_H_
+#define PCM_CODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Build-time selected codec for the PCM stream (CONFIG_PDM_CODEC_*).
+ * Captured blocks are shared read-only between the fan-out subscribers,
+ * so the codec never writes to them: raw PCM goes out of the slab block
+ * as it is, the other codecs encode into an out buffer of
+ * PCM_CODEC_OUT_BYTES(size) that the caller keeps until the frame is sent.
+ */
+
+/* Smallest PCM block the codec handles; its encoding is never longer */
+#if defined(CONFIG_PDM_CODEC_SPECTRUM)
+#define SPECTRUM_LEVELS  (CONFIG_PDM_SPECTRUM_BANDS ? CONFIG_PDM_SPECTRUM_BANDS \
+                                                    : CONFIG_PDM_SPECTRUM_FFT_SIZE / 2)
+#define PCM_CODEC_MIN_BLOCK_BYTES  (4 + SPECTRUM_LEVELS)  /* one spectrum frame */
+#elif defined(CONFIG_PDM_CODEC_MFCC)
+/* with hop >= 2 * coefs, no block of at least this size encodes into more bytes */
+#define PCM_CODEC_MIN_BLOCK_BYTES  (4 * CONFIG_PDM_MFCC_COEFS + 12)
+#else
+#define PCM_CODEC_MIN_BLOCK_BYTES  0
+#endif
+
+/* Largest encoding of pcm_bytes of PCM, 0 = sent as it is */
+#if defined(CONFIG_PDM_CODEC_ADPCM)
+#include "ima_adpcm.h"
+#define PCM_CODEC_OUT_BYTES(pcm_bytes)  IMA_ADPCM_BLOCK_BYTES((pcm_bytes) / 2)
+#elif defined(CONFIG_PDM_CODEC_LOSSLESS)
+#include "fixed_rice.h"
+#define PCM_CODEC_OUT_BYTES(pcm_bytes)  FIXED_RICE_MAX_BYTES((pcm_bytes) / 2)
+#elif defined(CONFIG_PDM_CODEC_SPECTRUM)
+#define PCM_CODEC_OUT_BYTES(pcm_bytes)  PCM_CODEC_MIN_BLOCK_BYTES
+#elif defined(CONFIG_PDM_CODEC_MFCC)
+#include "mfcc.h"
+#define PCM_CODEC_OUT_BYTES(pcm_bytes)  MFCC_MAX_BYTES((pcm_bytes) / 2)
+#else
+#define PCM_CODEC_OUT_BYTES(pcm_bytes)  0
+#endif
+
+/* Only sample rate the codec works at, 0 = any */
+#if defined(CONFIG_PDM_CODEC_MFCC)
+#define PCM_CODEC_RATE_HZ  CONFIG_PDM_MFCC_RATE_HZ
+#else
+#define PCM_CODEC_RATE_HZ  0
+#endif
+
+/* TLV type of a batch of blocks encoded with the selected codec */
+uint8_t  pcm_codec_tlv_type(void);
+
+/* Forget inter-block state (stream restart) */
+void     pcm_codec_reset(void);
+
+/*
+ * Encodes size bytes of int16 PCM without touching them. Returns the
+ * encoded block, *len bytes: pcm itself for raw PCM, out otherwise.
+ */
+const void *pcm_codec_encode(const void *pcm, uint16_t size, void *out, uint16_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PCM_CODEC_H_
@@ -0,0 +1,111 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include "spectrum.h"
+
+#define TWO_PI  6.283185307f
+
+/* Levels per octave of power: 2 * 10 * log10(2), Q8 */
+#define LEVELS_PER_LOG2_Q8  1541
+
+/* p: bin or band power of the FFT output, scaled by 2^(2 * shift) */
+static uint8_t level(uint64_t p, int shift)
+{
+    if (p == 0) {
+        return 0;
+    }
+    int32_t d = fft_q15_log2_q8(p) - ((FFT_Q15_P0_LOG2 + 2 * shift) << 8);
+    int32_t l = 255 + ((d * LEVELS_PER_LOG2_Q8) >> 16);
+
+    return (uint8_t)(l < 0 ? 0 : (l > 255 ? 255 : l));
+}
+
+int spectrum_init(struct spectrum_state *st, uint16_t fft_size, uint16_t bands)
+{
+    const uint16_t half = fft_size / 2;
+
+    if (fft_q15_init(&st->fftq, fft_size) != 0 ||
+        bands > SPECTRUM_BANDS_MAX || (bands != 0 && bands > half - 1)) {
+        return -EINVAL;
+    }
+
+    st->fft_size = fft_size;
+    st->log2n = (uint8_t)__builtin_ctz(fft_size);
+    st->nbins = bands ? bands : half;
+    st->flags = bands ? SPECTRUM_FLAG_BANDS : 0;
+
+    /* periodic Hann */
+    for (uint16_t i = 0; i < fft_size; i++) {
+        st->window[i] = (int16_t)lroundf(32767.0f * (0.5f - 0.5f * cosf(TWO_PI * i / fft_size)));
+    }
+
+    if (bands != 0) {
+        st->edge[0] = 1;
+        for (uint16_t k = 1; k < bands; k++) {
+            uint16_t e = (uint16_t)(pow((double)half, (double)k / bands) + 0.5);
+
+            st->edge[k] = (e > st->edge[k - 1]) ? e : st->edge[k - 1] + 1;
+        }
+        st->edge[bands] = half;
+    }
+
+    spectrum_reset(st);
+    return 0;
+}
+
+void spectrum_reset(struct spectrum_state *st)
+{
+    memset(st->hist, 0, sizeof(st->hist));
+}
+
+size_t spectrum_encode_block(struct spectrum_state *st, const int16_t *in, size_t n,
+                             uint8_t *out)
+{
+    const uint16_t fft_n = st->fft_size;
+    const uint16_t half = fft_n / 2;
+
+    /* newest fft_n samples; in is free to be overwritten after this */
+    if (n >= fft_n) {
+        memcpy(st->hist, in + (n - fft_n), fft_n * sizeof(int16_t));
+    } else {
+        memmove(st->hist, st->hist + n, (fft_n - n) * sizeof(int16_t));
+        memcpy(st->hist + (fft_n - n), in, n * sizeof(int16_t));
+    }
+
+    for (uint16_t i = 0; i < fft_n; i++) {
+        st->frame[i] = (int16_t)((st->hist[i] * st->window[i]) >> 15);
+    }
+
+    const int shift = fft_q15_block_scale(st->frame, fft_n);
+
+    fft_q15_real(&st->fftq, st->frame, st->fft);
+
+    uint8_t *lv = out + SPECTRUM_HDR_BYTES;
+
+    if (st->flags & SPECTRUM_FLAG_BANDS) {
+        for (uint16_t b = 0; b < st->nbins; b++) {
+            uint64_t p = 0;
+
+            for (uint16_t k = st->edge[b]; k < st->edge[b + 1]; k++) {
+                p += (uint32_t)(st->fft[2 * k] * st->fft[2 * k]) +
+                     (uint32_t)(st->fft[2 * k + 1] * st->fft[2 * k + 1]);
+            }
+            lv[b] = level(p, shift);
+        }
+    } else {
+        for (uint16_t k = 0; k < half; k++) {
+            uint32_t p = (uint32_t)(st->fft[2 * k] * st->fft[2 * k]) +
+                         (uint32_t)(st->fft[2 * k + 1] * st->fft[2 * k + 1]);
+
+            lv[k] = level(p, shift);
+        }
+    }
+
+    out[0] = (uint8_t)st->nbins;
+    out[1] = (uint8_t)(st->nbins >> 8);
+    out[2] = st->log2n;
+    out[3] = st->flags;
+    return SPECTRUM_FRAME_BYTES(st->nbins);
+}
@@ -0,0 +1,68 @@
+#ifndef SPECTRUM_H_
+#define SPECTRUM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "fft_q15.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Spectrum frame: Hann windowed Q15 FFT of the newest fft_size samples,
+ * one frame per PCM block (shorter blocks overlap with the ones before).
+ *   nbins(u16 LE), log2(fft_size)(u8), flags(u8)
+ *   + nbins levels (u8): 255 + 2 * dBFS, i.e. 0.5 dB steps, 0 = -127.5 dBFS
+ *     or quieter. 0 dBFS is the peak bin of a full-scale sine.
+ *   flags bit0 (SPECTRUM_FLAG_BANDS): level k is the power of FFT bins
+ *     [edge(k), edge(k + 1)), edge(k) = max(edge(k - 1) + 1,
+ *     round((fft_size / 2) ^ (k / nbins))), edge(0) = 1, edge(nbins) =
+ *     fft_size / 2 (log spaced, at least one bin each, DC left out).
+ *     Otherwise level k is bin k, k < fft_size / 2.
+ *
+ * The window is scaled to the loudest sample before the FFT (block
+ * floating point), so quiet input keeps its resolution.
+ */
+#define SPECTRUM_HDR_BYTES          4
+#define SPECTRUM_FRAME_BYTES(nbins) (SPECTRUM_HDR_BYTES + (nbins))
+#define SPECTRUM_FLAG_BANDS         0x01
+#define SPECTRUM_FFT_MIN            FFT_Q15_MIN
+#define SPECTRUM_FFT_MAX            FFT_Q15_MAX
+#define SPECTRUM_BANDS_MAX          128
+
+struct spectrum_state {
+    uint16_t fft_size;
+    uint8_t  log2n;
+    uint8_t  flags;                 /* SPECTRUM_FLAG_* */
+    uint16_t nbins;                 /* levels per frame */
+    uint16_t edge[SPECTRUM_BANDS_MAX + 1];
+    int16_t  hist[SPECTRUM_FFT_MAX];
+    int16_t  window[SPECTRUM_FFT_MAX];
+    int16_t  frame[SPECTRUM_FFT_MAX];     /* windowed input, clobbered by the FFT */
+    int16_t  fft[2 * SPECTRUM_FFT_MAX];   /* re, im interleaved, X / (fft_size / 2) */
+    struct fft_q15 fftq;
+};
+
+/*
+ * fft_size: power of two, SPECTRUM_FFT_MIN..SPECTRUM_FFT_MAX.
+ * bands: 0 = every bin, else 1..min(SPECTRUM_BANDS_MAX, fft_size / 2 - 1).
+ * Returns 0 or -EINVAL.
+ */
+int    spectrum_init(struct spectrum_state *st, uint16_t fft_size, uint16_t bands);
+
+/* Forget the sample history (stream restart) */
+void   spectrum_reset(struct spectrum_state *st);
+
+/*
+ * Feeds n mono samples and writes one frame (SPECTRUM_FRAME_BYTES(nbins))
+ * to out, returns its length. out may point at in.
+ */
+size_t spectrum_encode_block(struct spectrum_state *st, const int16_t *in, size_t n,
+                             uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPECTRUM_H_
@@ -0,0 +1,102 @@
+#include <zephyr/kernel.h>
+#include <string.h>
+#include "pdm_cfg.h"
+#include "decim.h"
+#include "decim_kernels.h"
+#include "decim_taps.h"
+
+BUILD_ASSERT(DECIM_TAPS_FACTOR == DECIM_FACTOR, "decim_taps.h is stale, rebuild from scratch");
+BUILD_ASSERT((DECIM_FACTOR == 1 || DECIM_TAPS % 2 == 0) && DECIM_HALF_TAPS % 2 == 0,
+             "decim_dot() takes tap pairs");
+
+/*
+ * One FIR decimator. Each channel's delay line is stored twice over
+ * (hist[k] == hist[k + ntaps]), so the newest ntaps samples are always
+ * contiguous at hist[pos..pos + ntaps), oldest first, and the dot product
+ * needs no wrap-around.
+ */
+struct decim_fir {
+    const int16_t *taps;
+    int16_t *hist;      /* channels x 2 * ntaps */
+    uint16_t ntaps;
+    uint16_t pos;
+    uint8_t  factor;
+    uint8_t  phase;     /* inputs since the last output */
+};
+
+#if DECIM_FACTOR > 1
+static int16_t main_hist[CHANNELS_MAX * 2 * DECIM_TAPS];
+static struct decim_fir main_fir = {
+    .taps = decim_taps_q15, .hist = main_hist, .ntaps = DECIM_TAPS, .factor = DECIM_FACTOR,
+};
+#endif
+
+#if defined(CONFIG_PDM_DECIM_HALF_RATE)
+static int16_t half_hist[CHANNELS_MAX * 2 * DECIM_HALF_TAPS];
+static struct decim_fir half_fir = {
+    .taps = decim_half_taps_q15, .hist = half_hist, .ntaps = DECIM_HALF_TAPS, .factor = 2,
+};
+#endif
+
+static void fir_reset(struct decim_fir *f)
+{
+    memset(f->hist, 0, CHANNELS_MAX * 2 * f->ntaps * sizeof(int16_t));
+    f->pos = 0;
+    f->phase = 0;
+}
+
+/*
+ * out may be in: output n lands on frame n, and by then input frames
+ * up to n * factor are in the delay line.
+ */
+static uint32_t fir_run(struct decim_fir *f, const int16_t *in, int16_t *out,
+                        uint32_t frames, uint8_t channels)
+{
+    const uint16_t n = f->ntaps;
+    uint32_t produced = 0;
+
+    for (uint32_t i = 0; i < frames; i++) {
+        for (uint8_t c = 0; c < channels; c++) {
+            int16_t *h = f->hist + c * 2 * n;
+
+            h[f->pos] = h[f->pos + n] = in[i * channels + c];
+        }
+        f->pos = (f->pos + 1 == n) ? 0 : f->pos + 1;
+
+        if (++f->phase < f->factor) {
+            continue;
+        }
+        f->phase = 0;
+        for (uint8_t c = 0; c < channels; c++) {
+            out[produced * channels + c] = decim_dot(f->hist + c * 2 * n + f->pos, f->taps, n);
+        }
+        produced++;
+    }
+    return produced;
+}
+
+void decim_reset(void)
+{
+#if DECIM_FACTOR > 1
+    fir_reset(&main_fir);
+#endif
+#if defined(CONFIG_PDM_DECIM_HALF_RATE)
+    fir_reset(&half_fir);
+#endif
+}
+
+uint32_t decim_block(int16_t *pcm, uint32_t frames, uint8_t channels)
+{
+#if DECIM_FACTOR > 1
+    return fir_run(&main_fir, pcm, pcm, frames, channels);
+#else
+    return frames;
+#endif
+}
+
+#if defined(CONFIG_PDM_DECIM_HALF_RATE)
+uint32_t decim_half(const int16_t *pcm, uint32_t frames, uint8_t channels, int16_t *out)
+{
+    return fir_run(&half_fir, pcm, out, frames, channels);
+}
+#endif
@@ -0,0 +1,71 @@
+#ifndef DECIM_H_
+#define DECIM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sample rate decimation in the capture thread (CONFIG_PDM_DECIM).
+ *
+ * The DMIC captures at DECIM_FACTOR times the stream rate (pdm_cfg.h).
+ * decim_block() runs first on every block, in place in the slab block:
+ * anti-alias FIR and down-sampling in polyphase form, so the filter only
+ * runs once per output sample (taps multiply-adds per output, not per
+ * input) and output j is written over input frames that are already in
+ * the delay line. Everything after it (DC blocker, noise suppressor, AGC,
+ * VAD, codec, the host) sees a block of rate_hz audio, and the link
+ * carries 1 / DECIM_FACTOR of the bytes.
+ *
+ * decim_half() (CONFIG_PDM_DECIM_HALF_RATE) runs the processed block
+ * through a second 2:1 stage into a separate buffer (the tail of the slab
+ * block, see main.c), sent alongside as TLV_T_PCM_HALF_BATCH.
+ *
+ * Taps come from decim_taps.py at build time: Kaiser-windowed sinc, -6 dB
+ * at CONFIG_PDM_DECIM_CUTOFF_PCT of the output Nyquist, factor x
+ * CONFIG_PDM_DECIM_TAPS_PER_PHASE taps (the group delay is half of that,
+ * at the input rate). Works on any number of interleaved channels.
+ */
+
+#if defined(CONFIG_PDM_DECIM_HALF_RATE)
+/* Half-rate copy of a stream block of block_bytes */
+#define DECIM_HALF_BYTES(block_bytes)  ((block_bytes) / 2)
+#else
+#define DECIM_HALF_BYTES(block_bytes)  0
+#endif
+
+#if defined(CONFIG_PDM_DECIM)
+/* Call before the first block of a stream (also after a restart) */
+void decim_reset(void);
+
+/*
+ * frames samples per channel at the capture rate; returns the frames left
+ * at the start of pcm (frames / DECIM_FACTOR).
+ */
+uint32_t decim_block(int16_t *pcm, uint32_t frames, uint8_t channels);
+#else
+static inline void decim_reset(void) {}
+static inline uint32_t decim_block(int16_t *pcm, uint32_t frames, uint8_t channels)
+{
+    return frames;
+}
+#endif
+
+#if defined(CONFIG_PDM_DECIM_HALF_RATE)
+/* Stream rate pcm in, half rate out (must not overlap); returns frames written */
+uint32_t decim_half(const int16_t *pcm, uint32_t frames, uint8_t channels, int16_t *out);
+#else
+static inline uint32_t decim_half(const int16_t *pcm, uint32_t frames, uint8_t channels,
+                                  int16_t *out)
+{
+    return 0;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DECIM_H_
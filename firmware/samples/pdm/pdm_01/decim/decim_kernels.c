@@ -0,0 +1,38 @@
+#include <string.h>
+#include "decim_kernels.h"
+
+static inline int16_t sat16(int32_t v)
+{
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+}
+
+/* decim_taps.py keeps sum(|h|) below 2^16, so the sum fits in int32 */
+int16_t decim_dot_c(const int16_t *x, const int16_t *h, uint32_t n)
+{
+    int32_t acc = 1 << 14;
+
+    for (uint32_t i = 0; i < n; i++) {
+        acc += x[i] * h[i];
+    }
+    return sat16(acc >> 15);
+}
+
+#if PDM_SIMD
+static inline uint32_t ld2(const int16_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+int16_t decim_dot_dsp(const int16_t *x, const int16_t *h, uint32_t n)
+{
+    uint32_t acc = 1 << 14;
+
+    for (uint32_t i = 0; i < n; i += 2) {
+        acc = __SMLAD(ld2(&x[i]), ld2(&h[i]), acc);
+    }
+    return sat16((int32_t)acc >> 15);
+}
+#endif
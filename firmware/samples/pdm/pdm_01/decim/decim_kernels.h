@@ -0,0 +1,32 @@
+#ifndef DECIM_KERNELS_H_
+#define DECIM_KERNELS_H_
+
+#include <stdint.h>
+#include "pdm_simd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * One decimator output: sum(x[i] * h[i]) over n Q15 taps, rounded and
+ * saturated to int16. n is even; x needs no alignment (the window slides
+ * one sample at a time). The _c version is the reference; the _dsp version
+ * (PDM_SIMD builds only) takes two taps per SMLAD and gives bit-identical
+ * results.
+ */
+int16_t decim_dot_c(const int16_t *x, const int16_t *h, uint32_t n);
+
+#if PDM_SIMD
+int16_t decim_dot_dsp(const int16_t *x, const int16_t *h, uint32_t n);
+
+#define decim_dot   decim_dot_dsp
+#else
+#define decim_dot   decim_dot_c
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DECIM_KERNELS_H_
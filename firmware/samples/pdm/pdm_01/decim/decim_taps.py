@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""
+Generates decim_taps.h for decim/decim.c at build time (CMakeLists.txt runs
+it with the CONFIG_PDM_DECIM_* values):
+
+  decim_taps_q15       anti-alias low-pass for the stream decimator,
+                       factor x taps_per_phase taps
+  decim_half_taps_q15  the same design for a further 2:1 step
+                       (CONFIG_PDM_DECIM_HALF_RATE), 2 x taps_per_phase taps
+
+Kaiser-windowed sinc, -6 dB at cutoff_pct percent of the output Nyquist,
+DC gain exactly 1.0 in Q15. The filters are symmetric (linear phase), so
+the tap order doubles as the time-reversed order the dot product needs.
+
+Standard library only: it runs under the Python the Zephyr build uses.
+"""
+import argparse
+import math
+
+KAISER_BETA = 7.0   # ~70 dB stopband
+
+
+def q15(x: float) -> int:
+    return max(-32768, min(32767, int(round(x * 32768.0))))
+
+
+def bessel_i0(x: float) -> float:
+    s, term, k = 1.0, 1.0, 1
+    while term > 1e-12 * s:
+        term *= (x / (2 * k)) ** 2
+        s += term
+        k += 1
+    return s
+
+
+def lowpass_q15(taps: int, factor: int, cutoff_pct: int) -> list[int]:
+    """Low-pass for factor:1, cutoff relative to the output Nyquist."""
+    fc = 0.5 * cutoff_pct / 100.0 / factor   # cycles per input sample
+    mid = (taps - 1) / 2.0
+    h = []
+    for i in range(taps):
+        t = i - mid
+        sinc = 2 * fc if t == 0 else math.sin(2 * math.pi * fc * t) / (math.pi * t)
+        w = bessel_i0(KAISER_BETA * math.sqrt(1.0 - (t / (mid + 0.5)) ** 2)) / bessel_i0(KAISER_BETA)
+        h.append(sinc * w)
+    total = sum(h)
+    q = [q15(v / total) for v in h]
+    # rounding leftovers go to the middle taps, keeping the DC gain and the symmetry
+    err = 32768 - sum(q)
+    c = taps // 2
+    if taps % 2:
+        q[c] += err
+    else:
+        q[c - 1] += err // 2
+        q[c] += err - err // 2
+    return q
+
+
+def c_array(ctype, name, values, per_line=12):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("    " + ", ".join(str(v) for v in values[i:i + per_line]) + ",")
+    return f"static const {ctype} {name}[{len(values)}] = {{\n" + "\n".join(lines) + "\n};\n"
+
+
+def main() -> None:
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--factor", type=int, required=True)
+    ap.add_argument("--taps-per-phase", type=int, required=True)
+    ap.add_argument("--cutoff-pct", type=int, required=True)
+    ap.add_argument("-o", "--output", required=True)
+    a = ap.parse_args()
+
+    if a.factor not in (1, 2, 4):
+        ap.error("factor must be 1, 2 or 4")
+    if not (2 <= a.taps_per_phase <= 64):
+        ap.error("need 2 <= taps-per-phase <= 64")
+    if not (10 <= a.cutoff_pct <= 100):
+        ap.error("need 10 <= cutoff-pct <= 100")
+
+    main_taps = lowpass_q15(a.factor * a.taps_per_phase, a.factor, a.cutoff_pct) if a.factor > 1 else [32767]
+    half_taps = lowpass_q15(2 * a.taps_per_phase, 2, a.cutoff_pct)
+    for t in (main_taps, half_taps):
+        # the Q15 dot product accumulates in int32
+        assert sum(abs(v) for v in t) < 65536
+
+    with open(a.output, "w", encoding="ascii") as f:
+        f.write(f"/* Generated by decim_taps.py --factor {a.factor} --taps-per-phase {a.taps_per_phase} "
+                f"--cutoff-pct {a.cutoff_pct}; do not edit */\n")
+        f.write("#ifndef DECIM_TAPS_H_\n#define DECIM_TAPS_H_\n\n#include <stdint.h>\n\n")
+        f.write(f"#define DECIM_TAPS_FACTOR   {a.factor}\n")
+        f.write(f"#define DECIM_TAPS          {len(main_taps)}\n")
+        f.write(f"#define DECIM_HALF_TAPS     {len(half_taps)}\n\n")
+        f.write(c_array("int16_t", "decim_taps_q15", main_taps) + "\n")
+        f.write(c_array("int16_t", "decim_half_taps_q15", half_taps) + "\n")
+        f.write("#endif // DECIM_TAPS_H_\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,375 @@
+#define DT_DRV_COMPAT pdm01_dmic_emul
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/audio/dmic.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+/* Same order as the "signal" enum in pdm01,dmic-emul.yaml */
+enum emul_signal {
+    EMUL_SINE = 0,
+    EMUL_CHIRP,
+    EMUL_NOISE,
+    EMUL_COUNTER,
+    EMUL_WAV,
+};
+
+#define SINE_LUT_BITS   10
+#define SINE_LUT_SIZE   (1u << SINE_LUT_BITS)
+
+struct dmic_emul_config {
+    enum emul_signal signal;
+    uint32_t freq_hz;
+    uint32_t chirp_end_hz;
+    uint32_t chirp_period_ms;
+    int16_t  amplitude;
+    uint16_t speedup;
+    struct k_msgq *rx_q;
+};
+
+enum emul_state {
+    EMUL_STATE_INIT = 0,
+    EMUL_STATE_CONFIGURED,
+    EMUL_STATE_ACTIVE,
+    EMUL_STATE_PAUSED,
+};
+
+struct dmic_emul_data {
+    const struct device *dev;
+    enum emul_state state;
+    struct k_timer timer;
+
+    struct k_mem_slab *slab;
+    uint16_t block_size;
+    uint32_t pcm_rate;
+    uint8_t  channels;
+
+    /* Signal state, only touched by emul_fill() */
+    uint64_t sample_idx;
+    uint32_t phase;         /* Q32 fraction of a turn */
+    uint32_t noise;
+    size_t   wav_pos;
+
+    uint32_t overruns;
+};
+
+static int16_t sine_lut[SINE_LUT_SIZE];
+static bool sine_lut_ready;
+
+#if defined(DMIC_EMUL_HAVE_WAV)
+static const uint8_t wav_file[] = {
+#include "dmic_emul_wav.inc"
+};
+static const uint8_t *wav_pcm;
+static size_t wav_frames;
+static uint16_t wav_stride;     /* bytes per frame, we take channel 0 */
+
+/* Finds the fmt/data chunks of a 16-bit PCM RIFF/WAVE file */
+static int wav_parse(void)
+{
+    if (sizeof(wav_file) < 12 || memcmp(wav_file, "RIFF", 4) || memcmp(&wav_file[8], "WAVE", 4)) {
+        return -EINVAL;
+    }
+
+    size_t off = 12;
+    uint16_t fmt = 0, bits = 0;
+
+    while (off + 8 <= sizeof(wav_file)) {
+        const uint8_t *ck = &wav_file[off];
+        uint32_t len = sys_get_le32(&ck[4]);
+
+        if (!memcmp(ck, "fmt ", 4) && len >= 16) {
+            fmt = sys_get_le16(&ck[8]);
+            wav_stride = sys_get_le16(&ck[20]);
+            bits = sys_get_le16(&ck[22]);
+        } else if (!memcmp(ck, "data", 4)) {
+            wav_pcm = &ck[8];
+            len = MIN(len, sizeof(wav_file) - off - 8);
+            wav_frames = wav_stride ? len / wav_stride : 0;
+            break;
+        }
+        off += 8 + len + (len & 1);
+    }
+
+    if (fmt != 1 || bits != 16 || wav_frames == 0) {
+        return -ENOTSUP;
+    }
+    return 0;
+}
+#endif
+
+static inline int16_t emul_next(struct dmic_emul_data *data, const struct dmic_emul_config *cfg)
+{
+    int16_t s;
+
+    switch (cfg->signal) {
+    case EMUL_SINE: {
+        uint32_t inc = (uint32_t)(((uint64_t)cfg->freq_hz << 32) / data->pcm_rate);
+
+        s = (int16_t)((sine_lut[data->phase >> (32 - SINE_LUT_BITS)] * cfg->amplitude) >> 15);
+        data->phase += inc;
+        break;
+    }
+    case EMUL_CHIRP: {
+        /* Instantaneous frequency ramps linearly over the period, then restarts */
+        uint64_t period = (uint64_t)data->pcm_rate * cfg->chirp_period_ms / 1000u;
+        uint64_t t = data->sample_idx % MAX(period, 1u);
+        int64_t  f = (int64_t)cfg->freq_hz +
+                     ((int64_t)cfg->chirp_end_hz - (int64_t)cfg->freq_hz) * (int64_t)t / (int64_t)MAX(period, 1u);
+
+        s = (int16_t)((sine_lut[data->phase >> (32 - SINE_LUT_BITS)] * cfg->amplitude) >> 15);
+        data->phase += (uint32_t)(((uint64_t)f << 32) / data->pcm_rate);
+        break;
+    }
+    case EMUL_NOISE:
+        data->noise ^= data->noise << 13;
+        data->noise ^= data->noise >> 17;
+        data->noise ^= data->noise << 5;
+        s = (int16_t)(((int32_t)(int16_t)data->noise * cfg->amplitude) >> 15);
+        break;
+#if defined(DMIC_EMUL_HAVE_WAV)
+    case EMUL_WAV:
+        s = (int16_t)sys_get_le16(&wav_pcm[data->wav_pos * wav_stride]);
+        if (++data->wav_pos == wav_frames) {
+            data->wav_pos = 0;
+        }
+        break;
+#endif
+    case EMUL_COUNTER:
+    default:
+        s = (int16_t)data->sample_idx;
+        break;
+    }
+
+    data->sample_idx++;
+    return s;
+}
+
+static void emul_fill(struct dmic_emul_data *data, const struct dmic_emul_config *cfg, int16_t *pcm)
+{
+    size_t frames = data->block_size / (sizeof(int16_t) * data->channels);
+
+    for (size_t i = 0; i < frames; i++) {
+        int16_t s = emul_next(data, cfg);
+
+        for (uint8_t c = 0; c < data->channels; c++) {
+            *pcm++ = s;
+        }
+    }
+}
+
+/* Skip a block's worth of signal, so an overrun shows up as a gap */
+static void emul_skip(struct dmic_emul_data *data, const struct dmic_emul_config *cfg)
+{
+    size_t frames = data->block_size / (sizeof(int16_t) * data->channels);
+
+    for (size_t i = 0; i < frames; i++) {
+        (void)emul_next(data, cfg);
+    }
+    data->overruns++;
+}
+
+/* One block "completed": like the PDM END interrupt of a real peripheral */
+static void emul_block(struct dmic_emul_data *data, const struct dmic_emul_config *cfg,
+                       k_timeout_t wait)
+{
+    void *buf;
+
+    if (k_mem_slab_alloc(data->slab, &buf, wait) != 0) {
+        emul_skip(data, cfg);
+        return;
+    }
+    emul_fill(data, cfg, buf);
+    if (k_msgq_put(cfg->rx_q, &buf, K_NO_WAIT) != 0) {
+        k_mem_slab_free(data->slab, buf);
+        data->overruns++;
+    }
+}
+
+static void emul_timer_fn(struct k_timer *timer)
+{
+    struct dmic_emul_data *data = CONTAINER_OF(timer, struct dmic_emul_data, timer);
+
+    emul_block(data, data->dev->config, K_NO_WAIT);
+}
+
+static void emul_flush(const struct device *dev)
+{
+    const struct dmic_emul_config *cfg = dev->config;
+    struct dmic_emul_data *data = dev->data;
+    void *buf;
+
+    while (k_msgq_get(cfg->rx_q, &buf, K_NO_WAIT) == 0) {
+        k_mem_slab_free(data->slab, buf);
+    }
+}
+
+static int dmic_emul_configure(const struct device *dev, struct dmic_cfg *config)
+{
+    struct dmic_emul_data *data = dev->data;
+    struct pcm_stream_cfg *stream = &config->streams[0];
+    uint8_t channels = config->channel.req_num_chan;
+
+    if (data->state == EMUL_STATE_ACTIVE) {
+        return -EBUSY;
+    }
+    if (config->channel.req_num_streams != 1 || stream->pcm_width != 16 ||
+        stream->pcm_rate == 0 || stream->mem_slab == NULL ||
+        channels == 0 || channels > 2 ||
+        stream->block_size % (sizeof(int16_t) * channels) != 0) {
+        return -EINVAL;
+    }
+
+    data->slab = stream->mem_slab;
+    data->block_size = stream->block_size;
+    data->pcm_rate = stream->pcm_rate;
+    data->channels = channels;
+
+    config->channel.act_num_streams = 1;
+    config->channel.act_num_chan = channels;
+    config->channel.act_chan_map_lo = config->channel.req_chan_map_lo;
+    config->channel.act_chan_map_hi = config->channel.req_chan_map_hi;
+
+    data->state = EMUL_STATE_CONFIGURED;
+    return 0;
+}
+
+static void emul_start_timer(const struct device *dev)
+{
+    const struct dmic_emul_config *cfg = dev->config;
+    struct dmic_emul_data *data = dev->data;
+
+    if (cfg->speedup == 0) {
+        return;     /* blocks are made on demand in dmic_emul_read() */
+    }
+
+    uint32_t frames = data->block_size / (sizeof(int16_t) * data->channels);
+    uint64_t period_us = (uint64_t)frames * USEC_PER_SEC / data->pcm_rate / cfg->speedup;
+    k_timeout_t period = K_USEC(MAX(period_us, 1u));
+
+    k_timer_start(&data->timer, period, period);
+}
+
+static int dmic_emul_trigger(const struct device *dev, enum dmic_trigger cmd)
+{
+    struct dmic_emul_data *data = dev->data;
+
+    switch (cmd) {
+    case DMIC_TRIGGER_START:
+    case DMIC_TRIGGER_RELEASE:
+        if (data->state != EMUL_STATE_CONFIGURED && data->state != EMUL_STATE_PAUSED) {
+            return -EIO;
+        }
+        data->state = EMUL_STATE_ACTIVE;
+        emul_start_timer(dev);
+        return 0;
+    case DMIC_TRIGGER_PAUSE:
+        if (data->state != EMUL_STATE_ACTIVE) {
+            return -EIO;
+        }
+        k_timer_stop(&data->timer);
+        data->state = EMUL_STATE_PAUSED;
+        return 0;
+    case DMIC_TRIGGER_STOP:
+        k_timer_stop(&data->timer);
+        if (data->state != EMUL_STATE_INIT) {
+            data->state = EMUL_STATE_CONFIGURED;
+        }
+        return 0;
+    case DMIC_TRIGGER_RESET:
+        k_timer_stop(&data->timer);
+        if (data->state != EMUL_STATE_INIT) {
+            emul_flush(dev);
+        }
+        data->state = EMUL_STATE_INIT;
+        data->sample_idx = 0;
+        data->phase = 0;
+        data->wav_pos = 0;
+        return 0;
+    default:
+        return -EINVAL;
+    }
+}
+
+static int dmic_emul_read(const struct device *dev, uint8_t stream,
+                          void **buffer, size_t *size, int32_t timeout)
+{
+    const struct dmic_emul_config *cfg = dev->config;
+    struct dmic_emul_data *data = dev->data;
+
+    if (stream != 0) {
+        return -EINVAL;
+    }
+    if (data->state == EMUL_STATE_INIT) {
+        return -EIO;
+    }
+    if (cfg->speedup == 0 && data->state == EMUL_STATE_ACTIVE) {
+        emul_block(data, cfg, SYS_TIMEOUT_MS(timeout));
+    }
+    if (k_msgq_get(cfg->rx_q, buffer, SYS_TIMEOUT_MS(timeout)) != 0) {
+        return -EAGAIN;
+    }
+    *size = data->block_size;
+    return 0;
+}
+
+static const struct _dmic_ops dmic_emul_ops = {
+    .configure = dmic_emul_configure,
+    .trigger   = dmic_emul_trigger,
+    .read      = dmic_emul_read,
+};
+
+static int dmic_emul_init(const struct device *dev)
+{
+    const struct dmic_emul_config *cfg = dev->config;
+    struct dmic_emul_data *data = dev->data;
+
+    if (!sine_lut_ready) {
+        for (unsigned int i = 0; i < SINE_LUT_SIZE; i++) {
+            sine_lut[i] = (int16_t)lroundf(32767.0f * sinf(2.0f * 3.14159265f * i / SINE_LUT_SIZE));
+        }
+        sine_lut_ready = true;
+    }
+
+#if defined(DMIC_EMUL_HAVE_WAV)
+    if (cfg->signal == EMUL_WAV && wav_parse() != 0) {
+        printk("%s: built-in WAV is not 16-bit PCM\n", dev->name);
+        return -ENOTSUP;
+    }
+#else
+    if (cfg->signal == EMUL_WAV) {
+        printk("%s: signal \"wav\" needs CONFIG_PDM_DMIC_EMUL_WAV_FILE\n", dev->name);
+        return -ENOTSUP;
+    }
+#endif
+
+    data->dev = dev;
+    data->noise = 0x12345678u;
+    data->state = EMUL_STATE_INIT;
+    k_timer_init(&data->timer, emul_timer_fn, NULL);
+    return 0;
+}
+
+#define DMIC_EMUL_DEFINE(n)                                                      \
+    K_MSGQ_DEFINE(dmic_emul_rx_q_##n, sizeof(void *),                            \
+                  DT_INST_PROP(n, read_queue_depth), sizeof(void *));            \
+    static const struct dmic_emul_config dmic_emul_config_##n = {                \
+        .signal          = (enum emul_signal)DT_INST_ENUM_IDX(n, signal),        \
+        .freq_hz         = DT_INST_PROP(n, frequency_hz),                        \
+        .chirp_end_hz    = DT_INST_PROP(n, chirp_end_hz),                        \
+        .chirp_period_ms = DT_INST_PROP(n, chirp_period_ms),                     \
+        .amplitude       = DT_INST_PROP(n, amplitude),                           \
+        .speedup         = DT_INST_PROP(n, speedup),                             \
+        .rx_q            = &dmic_emul_rx_q_##n,                                  \
+    };                                                                           \
+    static struct dmic_emul_data dmic_emul_data_##n;                             \
+    DEVICE_DT_INST_DEFINE(n, dmic_emul_init, NULL,                               \
+                          &dmic_emul_data_##n, &dmic_emul_config_##n,            \
+                          POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEVICE,       \
+                          &dmic_emul_ops);
+
+DT_INST_FOREACH_STATUS_OKAY(DMIC_EMUL_DEFINE)
@@ -0,0 +1,93 @@
+#include <zephyr/kernel.h>
+#include <errno.h>
+#include "fanout.h"
+
+static struct fanout_sub *subs[FANOUT_MAX_SUBS];
+static unsigned int n_subs;
+
+static struct k_mem_slab *slab;
+static const uint8_t *pool;
+static size_t block_bytes;
+static atomic_t refs[FANOUT_MAX_BLOCKS];
+
+static inline atomic_t *block_ref(const void *buf)
+{
+    return &refs[((const uint8_t *)buf - pool) / block_bytes];
+}
+
+int fanout_subscribe(struct fanout_sub *sub)
+{
+    if (n_subs == FANOUT_MAX_SUBS) {
+        return -ENOMEM;
+    }
+    atomic_clear(&sub->delivered);
+    atomic_clear(&sub->dropped);
+    subs[n_subs++] = sub;
+    return 0;
+}
+
+void fanout_attach(struct k_mem_slab *s, const void *p, size_t bytes)
+{
+    slab = s;
+    pool = p;
+    block_bytes = bytes;
+    for (size_t i = 0; i < FANOUT_MAX_BLOCKS; i++) {
+        atomic_clear(&refs[i]);
+    }
+}
+
+void fanout_ref(const void *buf)
+{
+    atomic_inc(block_ref(buf));
+}
+
+void fanout_release(const void *buf)
+{
+    if (atomic_dec(block_ref(buf)) == 1) {
+        k_mem_slab_free(slab, (void *)buf);
+    }
+}
+
+static void sub_drop(struct fanout_sub *s)
+{
+    atomic_inc(&s->dropped);
+    if (s->on_drop) {
+        s->on_drop();
+    }
+}
+
+unsigned int fanout_publish(const struct audio_item *item)
+{
+    atomic_t *ref = block_ref(item->buf);
+    unsigned int taken = 0;
+
+    /* our own reference: a fast subscriber may be done before the loop is */
+    atomic_set(ref, 1);
+
+    for (unsigned int i = 0; i < n_subs; i++) {
+        struct fanout_sub *s = subs[i];
+
+        atomic_inc(ref);
+        int ret = k_msgq_put(s->q, item, K_NO_WAIT);
+
+        if (ret != 0 && s->policy == FANOUT_DROP_OLDEST) {
+            struct audio_item oldest;
+
+            if (k_msgq_get(s->q, &oldest, K_NO_WAIT) == 0) {
+                fanout_release(oldest.buf);
+                sub_drop(s);
+            }
+            ret = k_msgq_put(s->q, item, K_NO_WAIT);
+        }
+        if (ret != 0) {
+            atomic_dec(ref);
+            sub_drop(s);
+            continue;
+        }
+        atomic_inc(&s->delivered);
+        taken++;
+    }
+
+    fanout_release(item->buf);
+    return taken;
+}
@@ -0,0 +1,92 @@
+#ifndef FANOUT_H_
+#define FANOUT_H_
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fan-out of captured blocks to several consumers, without copies.
+ *
+ * The capture thread publishes each slab block once. Every subscriber
+ * gets the same buffer in its own bounded k_msgq of struct audio_item,
+ * and the block goes back to audio_slab when the last of them calls
+ * fanout_release(). Reference counts live next to the slab (one per
+ * block, FANOUT_MAX_BLOCKS of them), so slab blocks stay plain DMIC
+ * buffers. A published block is read-only: subscribers see the same
+ * bytes, so anything they produce (the TX thread's codec output) goes
+ * into buffers of their own.
+ *
+ * Puts never wait: a subscriber with a full queue loses the block by its
+ * own policy, and the capture thread and the other subscribers don't
+ * notice. A subscriber pins at most its queue length plus whatever it
+ * took out and has not released yet, and the pool has to cover the sum.
+ *
+ * The UART path (tx_thread, drop-newest) is the first subscriber, the
+ * level meter (meter.h, drop-oldest) the second. Recorders and other DSP
+ * stages subscribe the same way, before capture starts.
+ */
+
+#define FANOUT_MAX_SUBS     CONFIG_PDM_FANOUT_MAX_SUBS
+#define FANOUT_MAX_BLOCKS   CONFIG_PDM_AUDIO_POOL_MAX_BLOCKS
+
+/* One captured block, as queued to each subscriber; read-only once published */
+struct audio_item {
+    const void *buf;
+    uint16_t size;
+    uint32_t ts_ms;     /* uptime of the first sample in the block */
+    uint64_t first_sample; /* running sample index, counts dropped blocks too */
+    uint32_t t_ready;   /* lat_now() when dmic_read() handed the block over */
+    uint32_t t_put;     /* lat_now() right before fanout_publish() */
+    bool     speech;    /* vad_block() verdict, hangover included */
+    bool     trigger;   /* trigger_level() verdict */
+};
+
+enum fanout_policy {
+    /* full queue: the new block skips this subscriber (keeps what it peeked at valid) */
+    FANOUT_DROP_NEWEST,
+    /* full queue: the oldest queued block is released to make room */
+    FANOUT_DROP_OLDEST,
+};
+
+struct fanout_sub {
+    struct k_msgq *q;           /* of struct audio_item */
+    enum fanout_policy policy;
+    void (*on_drop)(void);      /* capture thread, once per block lost; may be NULL */
+    atomic_t delivered;
+    atomic_t dropped;
+};
+
+/* Before capture starts; -ENOMEM past FANOUT_MAX_SUBS */
+int fanout_subscribe(struct fanout_sub *sub);
+
+/*
+ * Blocks of slab are carved from pool in block_bytes steps: call after
+ * every (re)carve, with no block out. Slabs of more than FANOUT_MAX_BLOCKS
+ * blocks must not be published.
+ */
+void fanout_attach(struct k_mem_slab *slab, const void *pool, size_t block_bytes);
+
+/*
+ * Capture thread: hand item->buf, fresh from the slab, to every
+ * subscriber. Returns how many took it; with none, the block is freed
+ * before this returns.
+ */
+unsigned int fanout_publish(const struct audio_item *item);
+
+/*
+ * One more / one less reference to a block; the last release frees it.
+ * Any context (fanout_release() runs in the UART ISR). A block fresh from
+ * the slab has no references: fanout_ref() makes it owned by the caller.
+ */
+void fanout_ref(const void *buf);
+void fanout_release(const void *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FANOUT_H_
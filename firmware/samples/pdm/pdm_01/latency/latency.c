@@ -0,0 +1,78 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <string.h>
+#include "latency.h"
+#include "tlv_link.h"
+
+struct lat_hist {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[LAT_BUCKETS];
+};
+
+static struct lat_hist hists[LAT_STAGES];
+static struct k_spinlock lat_lock;
+
+/* Dump frames go out zero-copy, one at a time */
+static uint8_t dump_buf[LAT_TLV_BYTES];
+K_SEM_DEFINE(dump_done, 0, 1);
+
+static inline unsigned int lat_bucket(uint32_t us)
+{
+    unsigned int b = (us < 2u) ? 0u : 31u - (unsigned int)__builtin_clz(us);
+
+    return MIN(b, LAT_BUCKETS - 1u);
+}
+
+void lat_record(enum lat_stage stage, uint32_t from, uint32_t to)
+{
+    uint32_t us = k_cyc_to_us_floor32(to - from);
+    unsigned int b = lat_bucket(us);
+
+    k_spinlock_key_t key = k_spin_lock(&lat_lock);
+    struct lat_hist *h = &hists[stage];
+
+    h->count++;
+    h->sum_us += us;
+    h->buckets[b]++;
+    if (us > h->max_us) {
+        h->max_us = us;
+    }
+    k_spin_unlock(&lat_lock, key);
+}
+
+static void dump_sent(void *user)
+{
+    ARG_UNUSED(user);
+    k_sem_give(&dump_done);
+}
+
+void lat_dump(bool reset)
+{
+    for (int s = 0; s < LAT_STAGES; s++) {
+        struct lat_hist snap;
+
+        k_spinlock_key_t key = k_spin_lock(&lat_lock);
+        snap = hists[s];
+        if (reset) {
+            memset(&hists[s], 0, sizeof(hists[s]));
+        }
+        k_spin_unlock(&lat_lock, key);
+
+        dump_buf[0] = (uint8_t)s;
+        dump_buf[1] = LAT_BUCKETS;
+        sys_put_le16(0, &dump_buf[2]);
+        sys_put_le32(snap.count, &dump_buf[4]);
+        sys_put_le32(snap.max_us, &dump_buf[8]);
+        sys_put_le64(snap.sum_us, &dump_buf[12]);
+        for (int b = 0; b < LAT_BUCKETS; b++) {
+            sys_put_le32(snap.buckets[b], &dump_buf[LAT_HDR_BYTES + 4 * b]);
+        }
+
+        struct tlv_seg seg = { dump_buf, LAT_TLV_BYTES };
+
+        tlv_link_send_segs(TLV_T_LAT_HIST, &seg, 1, dump_sent, NULL);
+        k_sem_take(&dump_done, K_FOREVER);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per-block latency through the pipeline, from cycle counter stamps:
+ *
+ *   dmic_read() returns -> k_msgq_put -> k_msgq_get -> TX start -> TX done
+ *         LAT_CAPTURE       LAT_QUEUE     LAT_ENCODE    LAT_LINK
+ *   \____________________________ LAT_TOTAL ___________________________/
+ *
+ * LAT_ENCODE covers batching and the codec, LAT_LINK the wait for a free
+ * tlv_link job plus the time on the wire. LAT_LINK is counted once per
+ * frame, the other stages once per block.
+ *
+ * Each stage keeps a fixed log2 histogram in microseconds: bucket 0 is
+ * [0, 2) us, bucket b is [2^b, 2^(b+1)) us, the last one is open ended.
+ * A TLV_T_LAT_DUMP request sends one TLV_T_LAT_HIST frame per stage:
+ *   stage(1) n_buckets(1) reserved(2) count(4) max_us(4) sum_us(8)
+ *   + n_buckets * count(4), all LE
+ */
+enum lat_stage {
+    LAT_CAPTURE = 0,
+    LAT_QUEUE,
+    LAT_ENCODE,
+    LAT_LINK,
+    LAT_TOTAL,
+    LAT_STAGES
+};
+
+#define LAT_BUCKETS        20     /* last bucket starts at 2^19 us (~0.5 s) */
+#define LAT_HDR_BYTES      20
+#define LAT_TLV_BYTES      (LAT_HDR_BYTES + 4 * LAT_BUCKETS)
+
+/* Stamps are raw k_cycle_get_32() values; differences survive the wrap */
+static inline uint32_t lat_now(void)
+{
+    return k_cycle_get_32();
+}
+
+#if defined(CONFIG_PDM_LATENCY)
+/* Safe from threads and ISRs */
+void lat_record(enum lat_stage stage, uint32_t from, uint32_t to);
+
+/* Send every histogram (blocks until they are on the wire), optionally clear */
+void lat_dump(bool reset);
+#else
+static inline void lat_record(enum lat_stage stage, uint32_t from, uint32_t to) {}
+static inline void lat_dump(bool reset) {}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LATENCY_H_
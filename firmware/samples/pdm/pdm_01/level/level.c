@@ -0,0 +1,124 @@
+#include <zephyr/kernel.h>
+#include <math.h>
+#include "level.h"
+#include "level_kernels.h"
+
+#define GAIN_ONE_Q11    2048
+
+#if defined(CONFIG_PDM_DC_BLOCK)
+static struct dc_block_state dc;
+static uint32_t dc_rate_hz;
+#endif
+
+#if defined(CONFIG_PDM_AGC)
+static uint32_t agc_rate_hz;
+static uint32_t env_q4;         /* peak envelope, int16 units in Q4 */
+static int16_t  gain_q11;
+
+/* Per chunk at agc_rate_hz, Q15 */
+static uint16_t att_q15;
+static uint16_t rel_q15;
+
+/* Fixed by Kconfig */
+static uint32_t target_q4;
+static uint32_t gate_q4;
+static int16_t  gain_max_q11;
+static int16_t  gain_min_q11;
+
+static uint16_t smooth_q15(uint32_t ms, uint32_t rate_hz)
+{
+    float tau = (float)ms * rate_hz / 1000.0f;
+
+    return (uint16_t)lroundf(32767.0f * (1.0f - expf(-(float)LEVEL_AGC_CHUNK / MAX(tau, 1.0f))));
+}
+
+static uint32_t dbfs_q4(int db)
+{
+    return (uint32_t)lroundf(32768.0f * 16.0f * powf(10.0f, db / 20.0f));
+}
+#endif
+
+void level_reset(void)
+{
+#if defined(CONFIG_PDM_DC_BLOCK)
+    dc = (struct dc_block_state){ 0 };
+    dc_rate_hz = 0;
+#endif
+#if defined(CONFIG_PDM_AGC)
+    target_q4 = dbfs_q4(CONFIG_PDM_AGC_TARGET_DBFS);
+    gate_q4 = dbfs_q4(CONFIG_PDM_AGC_GATE_DBFS);
+    gain_max_q11 = (int16_t)MIN(lroundf(GAIN_ONE_Q11 * powf(10.0f, CONFIG_PDM_AGC_MAX_GAIN_DB / 20.0f)),
+                                INT16_MAX);
+    gain_min_q11 = (int16_t)lroundf(GAIN_ONE_Q11 * powf(10.0f, -LEVEL_AGC_MAX_CUT_DB / 20.0f));
+
+    agc_rate_hz = 0;
+    env_q4 = 0;
+    gain_q11 = GAIN_ONE_Q11;
+#endif
+}
+
+#if defined(CONFIG_PDM_DC_BLOCK)
+void level_dc(int16_t *pcm, uint32_t frames, uint8_t channels, uint32_t rate_hz)
+{
+    if (channels != 1) {
+        return;
+    }
+    if (rate_hz != dc_rate_hz) {
+        /* a = 1 - 2 pi fc / fs */
+        dc.a_q14 = (int16_t)((1 << 14) - (102944u * CONFIG_PDM_DC_BLOCK_CUTOFF_HZ + rate_hz / 2) / rate_hz);
+        dc_rate_hz = rate_hz;
+    }
+    dc_block(&dc, pcm, frames);
+}
+#endif
+
+#if defined(CONFIG_PDM_AGC)
+static int16_t agc_target_gain(void)
+{
+    if (env_q4 == 0) {
+        return gain_q11;
+    }
+    uint32_t g = (uint32_t)(((uint64_t)target_q4 * GAIN_ONE_Q11) / env_q4);
+
+    return (int16_t)CLAMP(g, (uint32_t)gain_min_q11, (uint32_t)gain_max_q11);
+}
+
+void level_agc(int16_t *pcm, uint32_t frames, uint8_t channels, uint32_t rate_hz)
+{
+    if (channels != 1) {
+        return;
+    }
+    if (rate_hz != agc_rate_hz) {
+        att_q15 = smooth_q15(CONFIG_PDM_AGC_ATTACK_MS, rate_hz);
+        rel_q15 = smooth_q15(CONFIG_PDM_AGC_RELEASE_MS, rate_hz);
+        agc_rate_hz = rate_hz;
+    }
+
+    for (uint32_t i = 0; i < frames; i += LEVEL_AGC_CHUNK) {
+        const uint32_t n = MIN(frames - i, (uint32_t)LEVEL_AGC_CHUNK);
+        int16_t *x = &pcm[i];
+        int32_t peak = 0;
+
+        for (uint32_t j = 0; j < n; j++) {
+            int32_t v = x[j] < 0 ? -x[j] : x[j];
+
+            peak = MAX(peak, v);
+        }
+
+        uint32_t p = (uint32_t)peak << 4;
+
+        /* gated chunks leave the envelope (and so the gain) where speech put it */
+        if (p > env_q4) {
+            env_q4 += (uint32_t)(((uint64_t)(p - env_q4) * att_q15) >> 15);
+        } else if (p >= gate_q4) {
+            env_q4 -= (uint32_t)(((uint64_t)(env_q4 - p) * rel_q15) >> 15);
+        }
+
+        const int16_t g = agc_target_gain();
+        const int16_t step = (int16_t)((g - gain_q11) / (int32_t)n);
+
+        agc_ramp(x, n, gain_q11, step);
+        gain_q11 = (int16_t)(gain_q11 + step * (int32_t)n);
+    }
+}
+#endif
@@ -0,0 +1,55 @@
+#ifndef LEVEL_H_
+#define LEVEL_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Level conditioning of the captured audio, in place in the capture
+ * thread, mono streams only (multi-channel blocks go through untouched):
+ *
+ * level_dc() (CONFIG_PDM_DC_BLOCK): first-order IIR high-pass at
+ * CONFIG_PDM_DC_BLOCK_CUTOFF_HZ, removes the DMIC's DC offset ahead of
+ * everything else.
+ *
+ * level_agc() (CONFIG_PDM_AGC): peak envelope with attack / release per
+ * LEVEL_AGC_CHUNK samples, gain towards CONFIG_PDM_AGC_TARGET_DBFS within
+ * +CONFIG_PDM_AGC_MAX_GAIN_DB / -LEVEL_AGC_MAX_CUT_DB, ramped linearly
+ * across each chunk (no zipper noise). Chunks peaking below
+ * CONFIG_PDM_AGC_GATE_DBFS hold the envelope, so pauses keep the gain of
+ * the speech around them instead of pumping the background up. There is
+ * no look-ahead: the first chunk of a sudden loud onset can clip.
+ */
+#define LEVEL_AGC_CHUNK         32
+#define LEVEL_AGC_MAX_CUT_DB    24
+
+#if defined(CONFIG_PDM_DC_BLOCK) || defined(CONFIG_PDM_AGC)
+/* Call before the first block of a stream (also after a restart) */
+void level_reset(void);
+#else
+static inline void level_reset(void) {}
+#endif
+
+#if defined(CONFIG_PDM_DC_BLOCK)
+/* frames samples per channel */
+void level_dc(int16_t *pcm, uint32_t frames, uint8_t channels, uint32_t rate_hz);
+#else
+static inline void level_dc(int16_t *pcm, uint32_t frames, uint8_t channels,
+                            uint32_t rate_hz) {}
+#endif
+
+#if defined(CONFIG_PDM_AGC)
+void level_agc(int16_t *pcm, uint32_t frames, uint8_t channels, uint32_t rate_hz);
+#else
+static inline void level_agc(int16_t *pcm, uint32_t frames, uint8_t channels,
+                             uint32_t rate_hz) {}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LEVEL_H_
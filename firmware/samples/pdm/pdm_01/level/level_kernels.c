@@ -0,0 +1,109 @@
+#include <string.h>
+#include "level_kernels.h"
+
+#define AGC_Q   11
+
+static inline int16_t sat16(int32_t v)
+{
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+}
+
+/*
+ * Q14: (x - x1) * 2^14 + a * y1 + err stays below 2^31 for any input, so
+ * the DSP path can accumulate it in one register.
+ */
+void dc_block_c(struct dc_block_state *st, int16_t *x, uint32_t n)
+{
+    int32_t x1 = st->x1;
+    int32_t y1 = st->y1;
+    int32_t err = st->err;
+
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t v = (x[i] - x1) * (1 << 14) + st->a_q14 * y1 + err;
+
+        err = v & 0x3FFF;
+        x1 = x[i];
+        y1 = sat16(v >> 14);
+        x[i] = (int16_t)y1;
+    }
+    st->x1 = (int16_t)x1;
+    st->y1 = (int16_t)y1;
+    st->err = (uint16_t)err;
+}
+
+void agc_ramp_c(int16_t *x, uint32_t n, int16_t g0, int16_t step)
+{
+    int32_t g = g0;
+
+    for (uint32_t i = 0; i < n; i++, g += step) {
+        x[i] = sat16((x[i] * g + (1 << (AGC_Q - 1))) >> AGC_Q);
+    }
+}
+
+#if PDM_SIMD
+static inline uint32_t ld2(const int16_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void st2(int16_t *p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+void dc_block_dsp(struct dc_block_state *st, int16_t *x, uint32_t n)
+{
+    /* (x[n], x[n-1]) . (2^14, -2^14) */
+    const uint32_t diff = __PKHBT(1 << 14, (uint32_t)-(1 << 14), 16);
+    const uint32_t a = (uint16_t)st->a_q14;
+    uint32_t prev = (uint32_t)(uint16_t)st->x1 << 16;
+    int32_t y1 = st->y1;
+    int32_t err = st->err;
+    uint32_t i = 0;
+
+    for (; i + 1 < n; i += 2) {
+        uint32_t w = ld2(&x[i]);
+        int32_t v, y0;
+
+        v = (int32_t)__SMLAD(__PKHBT(w, prev, 0), diff, __SMLABB(a, (uint32_t)y1, err));
+        err = v & 0x3FFF;
+        y0 = __SSAT(v >> 14, 16);
+
+        v = (int32_t)__SMLAD(__ROR(w, 16), diff, __SMLABB(a, (uint32_t)y0, err));
+        err = v & 0x3FFF;
+        y1 = __SSAT(v >> 14, 16);
+
+        st2(&x[i], __PKHBT(y0, y1, 16));
+        prev = w;
+    }
+    st->x1 = (int16_t)(prev >> 16);
+    st->y1 = (int16_t)y1;
+    st->err = (uint16_t)err;
+    if (i < n) {
+        dc_block_c(st, &x[i], 1);
+    }
+}
+
+void agc_ramp_dsp(int16_t *x, uint32_t n, int16_t g0, int16_t step)
+{
+    /* gains of both samples in one word, advanced two steps at a time */
+    uint32_t g = __PKHBT(g0, g0 + step, 16);
+    const uint32_t inc = __PKHBT(2 * step, 2 * step, 16);
+    uint32_t i = 0;
+
+    for (; i + 1 < n; i += 2) {
+        uint32_t w = ld2(&x[i]);
+        int32_t lo = __SSAT((int32_t)__SMLABB(w, g, 1 << (AGC_Q - 1)) >> AGC_Q, 16);
+        int32_t hi = __SSAT((int32_t)__SMLATT(w, g, 1 << (AGC_Q - 1)) >> AGC_Q, 16);
+
+        st2(&x[i], __PKHBT(lo, hi, 16));
+        g = __QADD16(g, inc);
+    }
+    if (i < n) {
+        agc_ramp_c(&x[i], 1, (int16_t)(g0 + i * step), 0);
+    }
+}
+#endif
@@ -0,0 +1,49 @@
+#ifndef LEVEL_KERNELS_H_
+#define LEVEL_KERNELS_H_
+
+#include <stdint.h>
+#include "pdm_simd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * DC blocker and AGC gain kernels, in place on mono int16. The _c versions
+ * are the reference; the _dsp versions (PDM_SIMD builds only) work on
+ * sample pairs with SMLAD / QADD16 and give bit-identical results.
+ * Buffers are 4-byte aligned; odd lengths are fine.
+ */
+
+/* y[n] = x[n] - x[n-1] + a * y[n-1], a in Q14 */
+struct dc_block_state {
+    int16_t  a_q14;
+    int16_t  x1;        /* previous input */
+    int16_t  y1;        /* previous output */
+    uint16_t err;       /* rounding remainder, fed back so truncation adds no DC */
+};
+
+void dc_block_c(struct dc_block_state *st, int16_t *x, uint32_t n);
+
+/*
+ * x[i] *= g0 + i * step, gains Q11 (2048 = 1.0, up to 16x), rounded and
+ * saturated. g0 + (n - 1) * step must stay within int16.
+ */
+void agc_ramp_c(int16_t *x, uint32_t n, int16_t g0, int16_t step);
+
+#if PDM_SIMD
+void dc_block_dsp(struct dc_block_state *st, int16_t *x, uint32_t n);
+void agc_ramp_dsp(int16_t *x, uint32_t n, int16_t g0, int16_t step);
+
+#define dc_block    dc_block_dsp
+#define agc_ramp    agc_ramp_dsp
+#else
+#define dc_block    dc_block_c
+#define agc_ramp    agc_ramp_c
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LEVEL_KERNELS_H_
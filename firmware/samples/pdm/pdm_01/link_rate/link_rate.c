@@ -0,0 +1,163 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include <errno.h>
+#include "link_rate.h"
+#include "tlv_link.h"
+#include "test_pattern.h"
+
+#define LINK_RATE_MIN  9600
+
+BUILD_ASSERT(LINK_RATE_TEST_HDR + 2 * LINK_RATE_TEST_SAMPLES <= TLV_LINK_VALUE_MAX);
+
+/* All state changes happen on the system workqueue */
+static uint32_t boot_baud;
+static uint32_t good_baud;      /* last confirmed */
+static atomic_t trial_baud;     /* 0 = no trial running; claimed by the RX thread */
+static atomic_t confirm_ok;     /* set by the RX thread */
+
+static uint8_t test_buf[LINK_RATE_TEST_HDR + 2 * LINK_RATE_TEST_SAMPLES];
+static K_SEM_DEFINE(test_sent, 0, 1);
+
+static void switch_fn(struct k_work *work);
+static void burst_fn(struct k_work *work);
+static void verdict_fn(struct k_work *work);
+static void idle_fn(struct k_work *work);
+
+static K_WORK_DEFINE(switch_work, switch_fn);
+static K_WORK_DELAYABLE_DEFINE(burst_work, burst_fn);
+static K_WORK_DELAYABLE_DEFINE(verdict_work, verdict_fn);
+static K_WORK_DELAYABLE_DEFINE(idle_work, idle_fn);
+
+static void send_ack(int status, uint32_t baud)
+{
+    uint8_t v[12];
+
+    sys_put_le32((uint32_t)status, &v[0]);
+    sys_put_le32(baud, &v[4]);
+    sys_put_le32(boot_baud, &v[8]);
+    tlv_link_send(TLV_T_LINK_RATE_ACK, v, sizeof(v));
+}
+
+static void test_frame_sent(void *user)
+{
+    ARG_UNUSED(user);
+    k_sem_give(&test_sent);
+}
+
+static void switch_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+    uint32_t baud = (uint32_t)atomic_get(&trial_baud);
+
+    if (baud < LINK_RATE_MIN || baud > CONFIG_PDM_LINK_RATE_MAX) {
+        atomic_clear(&trial_baud);
+        send_ack(-EINVAL, good_baud);
+        return;
+    }
+
+    /* the ack goes out at the old rate; the host switches when it sees it */
+    send_ack(0, baud);
+    int ret = tlv_link_set_baud(baud, K_MSEC(LINK_RATE_SETTLE_MS));
+    if (ret) {
+        /* still on the old rate: the host hears no burst and comes back */
+        atomic_clear(&trial_baud);
+        return;
+    }
+
+    atomic_clear(&confirm_ok);
+    k_work_reschedule(&burst_work, K_NO_WAIT);
+}
+
+static void burst_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    for (int f = 0; f < LINK_RATE_TEST_FRAMES; f++) {
+        uint32_t first = f * LINK_RATE_TEST_SAMPLES;
+
+        test_buf[0] = (uint8_t)f;
+        test_buf[1] = LINK_RATE_TEST_FRAMES;
+        sys_put_le16(0, &test_buf[2]);
+        sys_put_le32(first, &test_buf[4]);
+        for (int i = 0; i < LINK_RATE_TEST_SAMPLES; i++) {
+            sys_put_le16((uint16_t)test_pattern_hash(first + i),
+                         &test_buf[LINK_RATE_TEST_HDR + 2 * i]);
+        }
+
+        struct tlv_seg seg = { test_buf, sizeof(test_buf) };
+
+        tlv_link_send_segs(TLV_T_LINK_TEST, &seg, 1, test_frame_sent, NULL);
+        k_sem_take(&test_sent, K_FOREVER);
+    }
+    /* no-op if a confirm already queued the verdict */
+    k_work_schedule(&verdict_work, K_MSEC(CONFIG_PDM_LINK_RATE_CONFIRM_MS));
+}
+
+/* Confirm timeout, or the RX thread pulled it forward */
+static void verdict_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+    int ok = atomic_get(&confirm_ok);
+    uint32_t baud = (uint32_t)atomic_get(&trial_baud);
+
+    if (baud == 0) {
+        return;
+    }
+    if (ok > 0) {
+        good_baud = baud;
+        atomic_clear(&trial_baud);
+        send_ack(0, good_baud);
+        if (good_baud != boot_baud) {
+            k_work_reschedule(&idle_work, K_MSEC(CONFIG_PDM_LINK_RATE_IDLE_MS));
+        }
+        return;
+    }
+
+    tlv_link_set_baud(good_baud, K_MSEC(LINK_RATE_SETTLE_MS));
+    atomic_clear(&trial_baud);
+    send_ack(ok < 0 ? -EIO : -ETIMEDOUT, good_baud);
+}
+
+static void idle_fn(struct k_work *work)
+{
+    ARG_UNUSED(work);
+
+    if (atomic_get(&trial_baud) != 0 || good_baud == boot_baud) {
+        return;
+    }
+    good_baud = boot_baud;
+    tlv_link_set_baud(boot_baud, K_NO_WAIT);
+}
+
+void link_rate_init(void)
+{
+    boot_baud = tlv_link_get_baud();
+    good_baud = boot_baud;
+}
+
+void link_rate_rx(uint8_t type, const uint8_t *val, uint16_t len)
+{
+    if (good_baud != boot_baud) {
+        k_work_reschedule(&idle_work, K_MSEC(CONFIG_PDM_LINK_RATE_IDLE_MS));
+    }
+
+    switch (type) {
+    case TLV_T_LINK_RATE:
+        if (len < 4 || sys_get_le32(val) == 0 ||
+            !atomic_cas(&trial_baud, 0, (atomic_val_t)sys_get_le32(val))) {
+            break;
+        }
+        k_work_submit(&switch_work);
+        break;
+    case TLV_T_LINK_CONFIRM:
+        if (atomic_get(&trial_baud) == 0) {
+            break;
+        }
+        atomic_set(&confirm_ok, (len > 0 && val[0]) ? 1 : -1);
+        k_work_reschedule(&verdict_work, K_NO_WAIT);
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef LINK_RATE_H_
+#define LINK_RATE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * UART baud rate negotiation with the host (CONFIG_PDM_LINK_RATE):
+ *
+ *   host                                device
+ *   TLV_T_LINK_RATE(baud)      ->
+ *                              <-       TLV_T_LINK_RATE_ACK(0, baud, boot)
+ *   both switch; the device keeps the line quiet for LINK_RATE_SETTLE_MS
+ *                              <-       LINK_RATE_TEST_FRAMES x TLV_T_LINK_TEST
+ *   TLV_T_LINK_CONFIRM(1)      ->       (at the new rate)
+ *                              <-       TLV_T_LINK_RATE_ACK(0, baud, boot)
+ *
+ * No confirm within CONFIG_PDM_LINK_RATE_CONFIRM_MS, or a confirm with
+ * ok = 0, puts the device back on the last good rate and it says so with
+ * TLV_T_LINK_RATE_ACK(-ETIMEDOUT / -EIO, good, boot). A refused proposal
+ * is answered at the current rate with status != 0 and nothing changes.
+ *
+ * TLV_T_LINK_TEST value: seq(1) count(1) reserved(2) first(4, LE)
+ *   + LINK_RATE_TEST_SAMPLES x test_pattern_hash(first + i) (int16 LE)
+ *
+ * At a negotiated rate the device returns to the boot rate when no host
+ * frame arrived for CONFIG_PDM_LINK_RATE_IDLE_MS (TLV_T_LINK_RATE(0) is
+ * the keepalive).
+ */
+#define LINK_RATE_SETTLE_MS     50
+#define LINK_RATE_TEST_FRAMES   8
+#define LINK_RATE_TEST_SAMPLES  256
+#define LINK_RATE_TEST_HDR      8
+
+#if defined(CONFIG_PDM_LINK_RATE)
+void link_rate_init(void);
+
+/* Every host -> device frame; runs in the tlv_link RX thread */
+void link_rate_rx(uint8_t type, const uint8_t *val, uint16_t len);
+#else
+static inline void link_rate_init(void) {}
+static inline void link_rate_rx(uint8_t type, const uint8_t *val, uint16_t len) {}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LINK_RATE_H_
@@ -0,0 +1,82 @@
+#include <zephyr/kernel.h>
+#include <math.h>
+#include <stdlib.h>
+#include "meter.h"
+#include "fanout.h"
+
+#define METER_STACK_SIZE  1024
+#define METER_PRIO        7       /* below TX (5) and the link RX thread (6) */
+
+K_MSGQ_DEFINE(meter_q, sizeof(struct audio_item), METER_Q_LEN, 4);
+
+static struct fanout_sub meter_sub = {
+    .q = &meter_q,
+    .policy = FANOUT_DROP_OLDEST,
+};
+
+K_THREAD_STACK_DEFINE(meter_stack, METER_STACK_SIZE);
+static struct k_thread meter_thread_data;
+
+/* Since the last meter_take() */
+static struct k_spinlock meter_lock;
+static uint16_t acc_peak;
+static uint64_t acc_sumsq;
+static uint32_t acc_n;
+
+static void meter_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1); ARG_UNUSED(p2); ARG_UNUSED(p3);
+
+    while (1) {
+        struct audio_item item;
+
+        k_msgq_get(&meter_q, &item, K_FOREVER);
+
+        const int16_t *pcm = item.buf;
+        const uint32_t n = item.size / sizeof(int16_t);
+        uint32_t peak = 0;
+        uint64_t sumsq = 0;
+
+        for (uint32_t i = 0; i < n; i++) {
+            int32_t s = pcm[i];
+
+            peak = MAX(peak, (uint32_t)abs(s));
+            sumsq += (uint32_t)(s * s);
+        }
+        fanout_release(item.buf);
+
+        k_spinlock_key_t key = k_spin_lock(&meter_lock);
+        acc_peak = (uint16_t)MAX(acc_peak, peak);
+        acc_sumsq += sumsq;
+        acc_n += n;
+        k_spin_unlock(&meter_lock, key);
+    }
+}
+
+int meter_start(void)
+{
+    int ret = fanout_subscribe(&meter_sub);
+
+    if (ret) {
+        return ret;
+    }
+    k_thread_create(&meter_thread_data, meter_stack, METER_STACK_SIZE,
+                    meter_thread, NULL, NULL, NULL, METER_PRIO, 0, K_NO_WAIT);
+    return 0;
+}
+
+void meter_take(uint16_t *peak, uint16_t *rms, uint32_t *dropped)
+{
+    k_spinlock_key_t key = k_spin_lock(&meter_lock);
+    uint64_t sumsq = acc_sumsq;
+    uint32_t n = acc_n;
+
+    *peak = acc_peak;
+    acc_peak = 0;
+    acc_sumsq = 0;
+    acc_n = 0;
+    k_spin_unlock(&meter_lock, key);
+
+    *rms = n ? (uint16_t)sqrtf((float)(sumsq / n)) : 0;
+    *dropped = (uint32_t)atomic_get(&meter_sub.dropped);
+}
@@ -0,0 +1,43 @@
+#ifndef METER_H_
+#define METER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Level meter on the fan-out (CONFIG_PDM_METER): a subscriber next to the
+ * TX thread that reads every published block, all channels, in a thread
+ * of its own below the UART path. It keeps the peak and the mean square
+ * since the last meter_take(); TLV_T_STATS reports them once per period.
+ *
+ * Drop-oldest on a queue of METER_Q_LEN blocks: a meter that falls behind
+ * skips the oldest blocks and counts them, capture and TX never wait.
+ */
+#if defined(CONFIG_PDM_METER)
+#define METER_Q_LEN  4
+
+/* Subscribe and start the meter thread; before capture starts */
+int  meter_start(void);
+
+/* Peak |sample| and RMS since the last call (0 without blocks), blocks skipped since boot */
+void meter_take(uint16_t *peak, uint16_t *rms, uint32_t *dropped);
+#else
+#define METER_Q_LEN  0
+
+static inline int meter_start(void) { return 0; }
+static inline void meter_take(uint16_t *peak, uint16_t *rms, uint32_t *dropped)
+{
+    *peak = 0;
+    *rms = 0;
+    *dropped = 0;
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METER_H_
@@ -0,0 +1,205 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <string.h>
+#include <math.h>
+#include "ns.h"
+#include "ns_kernels.h"
+#include "fft_q15.h"
+
+#define PI  3.141592654f
+
+/* Log powers are log2 in Q8 */
+#define Q8(x)           ((int32_t)((x) * 256))
+
+/* Recursive smoothing of the log power per frame, 1 / 4 of the new frame */
+#define SMOOTH_SHIFT    2
+
+/*
+ * The minimum of NS_MS_FRAMES smoothed log powers sits about this far
+ * below the mean noise power (the log of a periodogram bin alone averages
+ * 0.83 below the log of its mean). Set a little high on white noise, so
+ * noise peaks are subtracted too.
+ */
+#define MS_BIAS_Q8      Q8(3)
+
+/* Gain table steps of 1/8 log2 (0.375 dB) of P / N, 48 dB */
+#define GAIN_STEP_SHIFT 5
+#define GAIN_STEPS      128
+
+static atomic_t ns_req = ATOMIC_INIT(IS_ENABLED(CONFIG_PDM_NS_DEFAULT_ON));
+static bool ns_active;  /* capture thread */
+
+static struct fft_q15 fftq;
+static int16_t  win_q15[NS_FRAME] __aligned(4);        /* sqrt periodic Hann */
+static int16_t  gain_q15[GAIN_STEPS];
+
+static int16_t  hist[NS_FRAME] __aligned(4);           /* input, newest last */
+static int16_t  out_q[NS_HOP] __aligned(4);            /* finished output samples */
+static int16_t  ola[NS_FRAME] __aligned(4);            /* overlap-add accumulator */
+static uint16_t phase;                                 /* samples since the last frame */
+
+static int16_t  frame[NS_FFT_SIZE] __aligned(4);
+static int16_t  spec[2 * NS_FFT_SIZE] __aligned(4);
+static uint32_t pow_bin[NS_BINS];
+static int16_t  gain_bin[NS_BINS] __aligned(4);
+
+/* Per bin, log2 Q8 */
+static int16_t  smooth[NS_BINS];
+static int16_t  cur_min[NS_BINS];                      /* this subwindow so far */
+static int16_t  sub_min[NS_MS_SUBWIN][NS_BINS];        /* finished subwindows */
+static int16_t  ring_min[NS_BINS];                     /* min over sub_min */
+static uint8_t  sub_slot;
+static uint8_t  sub_frames;
+static bool     primed;
+
+static void ns_state_reset(void)
+{
+    memset(hist, 0, sizeof(hist));
+    memset(out_q, 0, sizeof(out_q));
+    memset(ola, 0, sizeof(ola));
+    phase = 0;
+
+    for (uint16_t k = 0; k < NS_BINS; k++) {
+        cur_min[k] = INT16_MAX;
+        ring_min[k] = INT16_MAX;
+        for (uint8_t u = 0; u < NS_MS_SUBWIN; u++) {
+            sub_min[u][k] = INT16_MAX;
+        }
+    }
+    sub_slot = 0;
+    sub_frames = 0;
+    primed = false;
+}
+
+void ns_reset(void)
+{
+    const float gmin = powf(10.0f, -CONFIG_PDM_NS_MAX_ATTEN_DB / 20.0f);
+    const float beta = CONFIG_PDM_NS_OVERSUB_PCT / 100.0f;
+
+    fft_q15_init(&fftq, NS_FFT_SIZE);
+    for (uint16_t i = 0; i < NS_FRAME; i++) {
+        win_q15[i] = (int16_t)lroundf(32767.0f * sinf(PI * i / NS_FRAME));
+    }
+    /* sampled mid step; P / N = 2^d */
+    for (uint16_t j = 0; j < GAIN_STEPS; j++) {
+        float d = (j + 0.5f) / (1 << (8 - GAIN_STEP_SHIFT));
+        float g2 = 1.0f - beta * powf(2.0f, -d);
+
+        g2 = MAX(g2, gmin * gmin);
+        gain_q15[j] = (int16_t)lroundf(32767.0f * sqrtf(g2));
+    }
+    ns_state_reset();
+    ns_active = atomic_get(&ns_req) != 0;
+}
+
+void ns_set_enabled(bool on)
+{
+    atomic_set(&ns_req, on ? 1 : 0);
+}
+
+bool ns_enabled(void)
+{
+    return atomic_get(&ns_req) != 0;
+}
+
+/* Noise tracking and gains from the power spectrum; shift from the block scaling */
+static void ns_gains(int shift)
+{
+    if (++sub_frames == NS_MS_SUBWIN_FRAMES) {
+        sub_frames = 0;
+        memcpy(sub_min[sub_slot], cur_min, sizeof(cur_min));
+        sub_slot = (sub_slot + 1) % NS_MS_SUBWIN;
+    }
+
+    for (uint16_t k = 0; k < NS_BINS; k++) {
+        int32_t l = fft_q15_log2_q8((uint64_t)pow_bin[k] | 1u) - shift * 512;
+        int32_t s = primed ? smooth[k] + ((l - smooth[k]) >> SMOOTH_SHIFT) : l;
+
+        smooth[k] = (int16_t)s;
+        if (sub_frames == 0) {
+            /* a subwindow just closed: refresh the min over the ring, start a new one */
+            int16_t m = sub_min[0][k];
+
+            for (uint8_t u = 1; u < NS_MS_SUBWIN; u++) {
+                m = MIN(m, sub_min[u][k]);
+            }
+            ring_min[k] = m;
+            cur_min[k] = (int16_t)s;
+        } else {
+            cur_min[k] = (int16_t)MIN(cur_min[k], s);
+        }
+
+        /*
+         * Gain from the smoothed power (no isolated noise peaks, less
+         * musical noise), or the frame's own power when that is lower:
+         * the gain falls at the end of a word instead of with the smoothing.
+         */
+        int32_t d = MIN(l, s) - (MIN(ring_min[k], cur_min[k]) + MS_BIAS_Q8);
+        int32_t j = d <= 0 ? 0 : MIN(d >> GAIN_STEP_SHIFT, GAIN_STEPS - 1);
+
+        gain_bin[k] = gain_q15[j];
+    }
+    primed = true;
+}
+
+static void ns_frame(void)
+{
+    ns_window(frame, hist, win_q15, NS_FRAME);
+    memset(&frame[NS_FRAME], 0, (NS_FFT_SIZE - NS_FRAME) * sizeof(int16_t));
+
+    const int shift = fft_q15_block_scale(frame, NS_FRAME);
+
+    fft_q15_real(&fftq, frame, spec);
+    ns_power(pow_bin, spec, NS_BINS);
+    ns_gains(shift);
+    ns_gain(spec, gain_bin, NS_BINS);
+    fft_q15_real_inverse(&fftq, spec, frame);
+
+    ns_window(frame, frame, win_q15, NS_FRAME);
+    if (shift > 0) {
+        for (uint16_t i = 0; i < NS_FRAME; i++) {
+            frame[i] = (int16_t)((frame[i] + (1 << (shift - 1))) >> shift);
+        }
+    } else if (shift < 0) {
+        for (uint16_t i = 0; i < NS_FRAME; i++) {
+            frame[i] = (int16_t)CLAMP(frame[i] * 2, INT16_MIN, INT16_MAX);
+        }
+    }
+    ns_ola(ola, frame, NS_FRAME);
+
+    /* the older half has all its frames now */
+    memcpy(out_q, ola, sizeof(out_q));
+    memmove(ola, &ola[NS_HOP], (NS_FRAME - NS_HOP) * sizeof(int16_t));
+    memset(&ola[NS_FRAME - NS_HOP], 0, NS_HOP * sizeof(int16_t));
+}
+
+bool ns_block(int16_t *pcm, uint32_t frames, uint8_t channels)
+{
+    const bool on = atomic_get(&ns_req) != 0 && channels == 1;
+
+    if (on != ns_active) {
+        ns_active = on;
+        if (on) {
+            ns_state_reset();
+        }
+    }
+    if (!on) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < frames;) {
+        const uint16_t take = (uint16_t)MIN(frames - i, (uint32_t)(NS_HOP - phase));
+
+        memmove(hist, &hist[take], (NS_FRAME - take) * sizeof(int16_t));
+        memcpy(&hist[NS_FRAME - take], &pcm[i], take * sizeof(int16_t));
+        memcpy(&pcm[i], &out_q[phase], take * sizeof(int16_t));
+        i += take;
+        phase += take;
+
+        if (phase == NS_HOP) {
+            phase = 0;
+            ns_frame();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef NS_H_
+#define NS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed-point noise suppressor (CONFIG_PDM_NS). Runs in the capture thread
+ * on the raw int16 PCM, in place, ahead of the VAD and the codec, so every
+ * codec sends the cleaned audio.
+ *
+ * Short-time spectral gain with overlap-add: NS_FRAME sample frames every
+ * NS_HOP samples, sqrt-Hann analysis and synthesis windows (they add up to
+ * one at 50% overlap, so a gain of one gives the input back), zero padded
+ * Q15 FFT. Per bin, the noise power is the minimum of the smoothed log
+ * power over the last NS_MS_FRAMES frames plus a bias correction (minimum
+ * statistics: tracks a fan or hum switching on within about a second and
+ * never needs to know when someone speaks). The gain is power spectral
+ * subtraction, sqrt(1 - beta * N / P) with beta = CONFIG_PDM_NS_OVERSUB_PCT
+ * / 100, floored at -CONFIG_PDM_NS_MAX_ATTEN_DB.
+ *
+ * Delays the audio by NS_FRAME samples (20 ms at 16 kHz). Mono streams
+ * only: blocks of multi-channel streams go through untouched. Switching
+ * on restarts from silence (the first NS_FRAME samples are zero) and
+ * switching off drops the delay, so the audio jumps by NS_FRAME samples
+ * either way.
+ */
+
+#if defined(CONFIG_PDM_NS)
+#define NS_FRAME        320
+#define NS_HOP          (NS_FRAME / 2)
+#define NS_FFT_SIZE     512
+#define NS_BINS         (NS_FFT_SIZE / 2 + 1)
+
+/* Minimum statistics window: NS_MS_SUBWIN minima of NS_MS_SUBWIN_FRAMES frames each */
+#define NS_MS_SUBWIN        4
+#define NS_MS_SUBWIN_FRAMES 24
+#define NS_MS_FRAMES        (NS_MS_SUBWIN * NS_MS_SUBWIN_FRAMES)
+
+/* Call before the first block of a stream (also after a restart) */
+void ns_reset(void);
+
+/* Any thread; takes effect at the next block */
+void ns_set_enabled(bool on);
+bool ns_enabled(void);
+
+/*
+ * frames samples per channel. Returns true if the block was processed,
+ * false if it went through as is (suppressor off, or more than one channel).
+ */
+bool ns_block(int16_t *pcm, uint32_t frames, uint8_t channels);
+#else
+static inline void ns_reset(void) {}
+static inline void ns_set_enabled(bool on) {}
+static inline bool ns_enabled(void) { return false; }
+static inline bool ns_block(int16_t *pcm, uint32_t frames, uint8_t channels) { return false; }
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NS_H_
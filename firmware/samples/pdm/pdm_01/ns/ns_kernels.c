@@ -0,0 +1,96 @@
+#include <string.h>
+#include "ns_kernels.h"
+
+static inline int16_t sat16(int32_t v)
+{
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+}
+
+void ns_window_c(int16_t *dst, const int16_t *x, const int16_t *w, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        dst[i] = (int16_t)((x[i] * w[i] + (1 << 14)) >> 15);
+    }
+}
+
+void ns_power_c(uint32_t *p, const int16_t *spec, uint16_t bins)
+{
+    for (uint16_t k = 0; k < bins; k++) {
+        int32_t re = spec[2 * k];
+        int32_t im = spec[2 * k + 1];
+
+        p[k] = (uint32_t)(re * re) + (uint32_t)(im * im);
+    }
+}
+
+void ns_gain_c(int16_t *spec, const int16_t *g, uint16_t bins)
+{
+    for (uint16_t k = 0; k < bins; k++) {
+        spec[2 * k] = (int16_t)((spec[2 * k] * g[k] + (1 << 14)) >> 15);
+        spec[2 * k + 1] = (int16_t)((spec[2 * k + 1] * g[k] + (1 << 14)) >> 15);
+    }
+}
+
+void ns_ola_c(int16_t *acc, const int16_t *x, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        acc[i] = sat16(acc[i] + x[i]);
+    }
+}
+
+#if PDM_SIMD
+/* Two int16 per word; memcpy keeps it legal C, the compiler emits LDR / STR */
+static inline uint32_t ld2(const int16_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void st2(int16_t *p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+void ns_window_dsp(int16_t *dst, const int16_t *x, const int16_t *w, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i += 2) {
+        uint32_t xv = ld2(&x[i]);
+        uint32_t wv = ld2(&w[i]);
+        int32_t lo = (int32_t)__SMLABB(xv, wv, 1 << 14) >> 15;
+        int32_t hi = (int32_t)__SMLATT(xv, wv, 1 << 14) >> 15;
+
+        st2(&dst[i], __PKHBT(lo, hi, 16));
+    }
+}
+
+void ns_power_dsp(uint32_t *p, const int16_t *spec, uint16_t bins)
+{
+    for (uint16_t k = 0; k < bins; k++) {
+        uint32_t v = ld2(&spec[2 * k]);
+
+        /* 2 * (-32768)^2 wraps to 2^31 as int32: the bits are the uint32 sum */
+        p[k] = (uint32_t)__SMUAD(v, v);
+    }
+}
+
+void ns_gain_dsp(int16_t *spec, const int16_t *g, uint16_t bins)
+{
+    for (uint16_t k = 0; k < bins; k++) {
+        uint32_t v = ld2(&spec[2 * k]);
+        uint32_t gv = (uint16_t)g[k];
+        int32_t re = (int32_t)__SMLABB(v, gv, 1 << 14) >> 15;
+        int32_t im = (int32_t)__SMLATB(v, gv, 1 << 14) >> 15;
+
+        st2(&spec[2 * k], __PKHBT(re, im, 16));
+    }
+}
+
+void ns_ola_dsp(int16_t *acc, const int16_t *x, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i += 2) {
+        st2(&acc[i], __QADD16(ld2(&acc[i]), ld2(&x[i])));
+    }
+}
+#endif
@@ -0,0 +1,51 @@
+#ifndef NS_KERNELS_H_
+#define NS_KERNELS_H_
+
+#include <stdint.h>
+#include "pdm_simd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Inner loops of the noise suppressor, on int16 pairs. The _c versions
+ * are the reference; the _dsp versions (PDM_SIMD builds only) use the Arm
+ * DSP extension and give bit-identical results. n (samples) is even,
+ * buffers are 4-byte aligned.
+ */
+
+/* dst[i] = x[i] * w[i], Q15, rounded; dst may be x */
+void ns_window_c(int16_t *dst, const int16_t *x, const int16_t *w, uint16_t n);
+
+/* p[k] = re^2 + im^2 of spec[2k], spec[2k + 1] */
+void ns_power_c(uint32_t *p, const int16_t *spec, uint16_t bins);
+
+/* (re, im) of bin k times g[k], Q15, rounded */
+void ns_gain_c(int16_t *spec, const int16_t *g, uint16_t bins);
+
+/* acc[i] += x[i], saturating */
+void ns_ola_c(int16_t *acc, const int16_t *x, uint16_t n);
+
+#if PDM_SIMD
+void ns_window_dsp(int16_t *dst, const int16_t *x, const int16_t *w, uint16_t n);
+void ns_power_dsp(uint32_t *p, const int16_t *spec, uint16_t bins);
+void ns_gain_dsp(int16_t *spec, const int16_t *g, uint16_t bins);
+void ns_ola_dsp(int16_t *acc, const int16_t *x, uint16_t n);
+
+#define ns_window   ns_window_dsp
+#define ns_power    ns_power_dsp
+#define ns_gain     ns_gain_dsp
+#define ns_ola      ns_ola_dsp
+#else
+#define ns_window   ns_window_c
+#define ns_power    ns_power_c
+#define ns_gain     ns_gain_c
+#define ns_ola      ns_ola_c
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NS_KERNELS_H_
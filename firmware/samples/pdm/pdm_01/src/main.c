@@ -3,129 +3,490 @@
 #include <zephyr/audio/dmic.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/sys/printk.h>
+#include <zephyr/sys/byteorder.h>
 #include <string.h>
 #include <errno.h>
+#include "pdm_cfg.h"
+#include "tlv_link.h"
+#include "pcm_codec.h"
+#include "stats.h"
+#include "latency.h"
+#include "link_rate.h"
+#include "vad.h"
+#include "ns.h"
+#include "level.h"
+#include "decim.h"
+#include "fanout.h"
+#include "trigger.h"
+#include "meter.h"
+
+#if !defined(CONFIG_PDM_TEST_PATTERN_NONE)
+#include "test_pattern.h"
+#endif
+
+#if defined(CONFIG_PDM_BENCH)
+#include "bench.h"
+#endif
+
+/* One block as it goes on the wire: the codec output or the PCM itself */
+#define BLOCK_WIRE_BYTES(pcm_bytes)  MAX((pcm_bytes), PCM_CODEC_OUT_BYTES(pcm_bytes))
+
+/*
+ * Slab block for stream blocks of pcm_bytes: the DMIC fills DECIM_FACTOR
+ * times that, decim_block() leaves pcm_bytes at the start, and the
+ * half-rate copy (CONFIG_PDM_DECIM_HALF_RATE) goes after both, out of the
+ * way of the decimator still reading its input. Once published, a block
+ * is read-only: the codec writes elsewhere (struct pcm_batch).
+ */
+#define SLAB_HALF_OFFSET(pcm_bytes)  ROUND_UP(DECIM_FACTOR * (pcm_bytes), 4)
+#define SLAB_BLOCK_BYTES(pcm_bytes)  ROUND_UP(SLAB_HALF_OFFSET(pcm_bytes) + DECIM_HALF_BYTES(pcm_bytes), 4)
+
+/*
+ * Fewest blocks a stream config may leave in the pool: the pre-roll holds
+ * some, the meter's queue and the block it works on pin a few more.
+ */
+#define POOL_MIN_BLOCKS(block_ms)  (4 + MAX(VAD_PREROLL_BLOCKS, TRIGGER_PREROLL_BLOCKS(block_ms)) + \
+                                    (METER_Q_LEN ? METER_Q_LEN + 1 : 0))
+
+/*
+ * audio_slab is carved out of audio_pool for the active stream config and
+ * re-carved on every reconfig, once all blocks are back (stream_reconfigure).
+ * Blocks are shared by the fanout subscribers and freed by the last one
+ * to release them.
+ */
+static char __aligned(4) audio_pool[CONFIG_PDM_AUDIO_POOL_BYTES];
+static struct k_mem_slab audio_slab;
+
+static struct pdm_stream_cfg stream = {
+    .rate_hz    = SAMPLE_RATE_HZ,
+    .block_ms   = BLOCK_MS,
+    .channels   = CHANNELS,
+    .width_bits = PCM_WIDTH_BITS,
+};
 
-/* Audio config */
-#define SAMPLE_RATE_HZ      16000
-#define PCM_WIDTH_BITS      16
-#define CHANNELS            1
+BUILD_ASSERT(BLOCK_SIZE_BYTES <= BLOCK_MAX_BYTES, "default block exceeds PDM_BLOCK_MAX_BYTES");
+BUILD_ASSERT(BLOCK_SIZE_BYTES >= PCM_CODEC_MIN_BLOCK_BYTES, "default block too short for the codec");
+BUILD_ASSERT(PCM_CODEC_RATE_HZ == 0 || PCM_CODEC_RATE_HZ == SAMPLE_RATE_HZ,
+             "codec built for another sample rate than the default stream");
+BUILD_ASSERT(CONFIG_PDM_AUDIO_POOL_BYTES / SLAB_BLOCK_BYTES(BLOCK_SIZE_BYTES) >= POOL_MIN_BLOCKS(BLOCK_MS),
+             "PDM_AUDIO_POOL_BYTES too small for the default stream");
+BUILD_ASSERT(POOL_MIN_BLOCKS(BLOCK_MS) <= CONFIG_PDM_AUDIO_POOL_MAX_BLOCKS,
+             "PDM_AUDIO_POOL_MAX_BLOCKS too small");
 
-#define BLOCK_MS            20
-#define SAMPLES_PER_BLOCK   ((SAMPLE_RATE_HZ * BLOCK_MS) / 1000)   /* 320 */
-#define BYTES_PER_SAMPLE    (PCM_WIDTH_BITS / 8)                   /* 2   */
-#define BLOCK_SIZE_BYTES    (SAMPLES_PER_BLOCK * BYTES_PER_SAMPLE * CHANNELS)
-#define BLOCK_COUNT         64
+const struct pdm_stream_cfg *pdm_stream_cfg_get(void)
+{
+    return &stream;
+}
 
-#define FRAME_HDR 0xAA55AA55u
-#define FRAME_FTR 0xA5A5A5A5u
+/* Bytes of one sample across all channels */
+static inline uint32_t stream_frame_bytes(void)
+{
+    return stream.channels * (stream.width_bits / 8u);
+}
 
-K_MEM_SLAB_DEFINE(audio_slab, BLOCK_SIZE_BYTES, BLOCK_COUNT, 4);
+/* Short blocks would cut the pool into more blocks than fanout counts references for */
+static inline size_t audio_slab_blocks(const struct pdm_stream_cfg *c)
+{
+    return MIN(sizeof(audio_pool) / SLAB_BLOCK_BYTES(pdm_stream_block_bytes(c)), FANOUT_MAX_BLOCKS);
+}
 
-/* ---------- TLV Types ---------- */
-#define TLV_T_PCM_BLOCK     0x01   /* raw PCM bytes */
-#define TLV_T_TIMESTAMP_MS  0x02   /* uint32 little-endian */
-#define TLV_T_SYNC          0x7F   /* ASCII "SYNC" */
+static void audio_slab_carve(const struct pdm_stream_cfg *c)
+{
+    size_t blk = SLAB_BLOCK_BYTES(pdm_stream_block_bytes(c));
 
-struct audio_item {
-    void    *buf;
-    uint16_t size;
-};
+    k_mem_slab_init(&audio_slab, audio_pool, blk, audio_slab_blocks(c));
+    fanout_attach(&audio_slab, audio_pool, blk);
+}
 
+/*
+ * The TX thread's subscription. Drop-newest: a full queue turns the
+ * block away at the door, so tx_peek() / tx_next() see the same blocks.
+ */
 #define AUDIO_Q_LEN  16
 K_MSGQ_DEFINE(audio_q, sizeof(struct audio_item), AUDIO_Q_LEN, 4);
 
+static struct fanout_sub tx_sub = {
+    .q = &audio_q,
+    .policy = FANOUT_DROP_NEWEST,
+    .on_drop = stats_block_dropped,
+};
+
 /* Threads */
 #define CAPTURE_STACK_SIZE 2048
 #define TX_STACK_SIZE      2048
 #define CAPTURE_PRIO  3
 #define TX_PRIO       5
 
-K_THREAD_STACK_DEFINE(capture_stack, CAPTURE_STACK_SIZE);
 K_THREAD_STACK_DEFINE(tx_stack, TX_STACK_SIZE);
-
-static struct k_thread capture_thread_data;
 static struct k_thread tx_thread_data;
 
-static const struct device *uart_dev;
-
+/*
+ * TLV_T_PCM_BATCH / TLV_T_ADPCM_BATCH / TLV_T_LOSSLESS_BATCH /
+ * TLV_T_SPECTRUM_BATCH / TLV_T_MFCC_BATCH value:
+ *   first_ts_ms(4 LE) + block_count(2 LE) + samples_per_block(2 LE)
+ *   + first_sample(8 LE)
+ *   + block_count * block (raw PCM, or one codec block per slab block)
+ *
+ * Samples are per channel (multi-channel PCM is interleaved). first_sample
+ * is the running index of the batch's first sample since capture
+ * (re)started. Blocks in a batch are always consecutive, so the host sees
+ * a lost block as a jump in first_sample.
+ *
+ * TLV_T_PCM_HALF_BATCH (CONFIG_PDM_DECIM_HALF_RATE) has the same layout,
+ * raw PCM at half the stream rate, with samples_per_block and first_sample
+ * at that rate. It goes out right before the batch of the same blocks.
+ */
+#define PCM_BATCH_HDR_BYTES  16
+
+BUILD_ASSERT(PCM_BATCH_HDR_BYTES + BLOCK_WIRE_BYTES(BLOCK_MAX_BYTES) <= TLV_LINK_VALUE_MAX,
+             "a PDM_BLOCK_MAX_BYTES block does not fit in one tlv_link frame");
+
+/* Codec output of one block; raw PCM is sent from the slab block instead */
+#define BATCH_ENC_BYTES  ROUND_UP(MAX(1, PCM_CODEC_OUT_BYTES(BLOCK_MAX_BYTES)), 4)
+
+struct pcm_batch {
+    uint8_t  hdr[PCM_BATCH_HDR_BYTES];
+#if defined(CONFIG_PDM_DECIM_HALF_RATE)
+    uint8_t  half_hdr[PCM_BATCH_HDR_BYTES];
+#endif
+    uint8_t  enc[CONFIG_PDM_BATCH_MAX_BLOCKS][BATCH_ENC_BYTES];
+    const void *bufs[CONFIG_PDM_BATCH_MAX_BLOCKS];
+    uint32_t t_ready[CONFIG_PDM_BATCH_MAX_BLOCKS];
+    uint32_t t_start;   /* handed to tlv_link */
+    uint8_t  count;
+};
 
+/* TLV_LINK_JOBS batches can be on the wire while the next one is filled */
+static struct pcm_batch pcm_batches[TLV_LINK_JOBS + 1];
 
-/* --- UART helpers (polling; simple + works everywhere) --- */
-static void uart_send_bytes_poll(const uint8_t *data, size_t len)
+/*
+ * Run in the UART ISR in async mode. done: tlv_link no longer needs the
+ * slab blocks (under COBS that is before the frame is sent); on_wire: the
+ * batch left the wire.
+ */
+static void pcm_batch_done(void *user)
 {
-    for (size_t i = 0; i < len; i++) {
-        uart_poll_out(uart_dev, data[i]);
-    }
-}
+    struct pcm_batch *batch = user;
 
-static void uart_send_u32_le_raw(uint32_t v)
-{
-    uint8_t b[4];
-    b[0] = (uint8_t)(v & 0xFF);
-    b[1] = (uint8_t)((v >> 8) & 0xFF);
-    b[2] = (uint8_t)((v >> 16) & 0xFF);
-    b[3] = (uint8_t)((v >> 24) & 0xFF);
-    uart_send_bytes_poll(b, 4);
+    for (uint8_t i = 0; i < batch->count; i++) {
+        fanout_release(batch->bufs[i]);
+    }
 }
 
-/* TLV: T(1) + L(2 LE) + V(L) */
-static void uart_send_tlv(uint8_t type, const void *val, uint16_t len)
+static void pcm_batch_on_wire(void *user)
 {
-    uint8_t hdr[3];
-    hdr[0] = type;
-    hdr[1] = (uint8_t)(len & 0xFF);
-    hdr[2] = (uint8_t)((len >> 8) & 0xFF);
+    struct pcm_batch *batch = user;
+    uint32_t now = lat_now();
 
-    uart_send_u32_le_raw(FRAME_HDR);
-    
-    uart_send_bytes_poll(hdr, sizeof(hdr));
-    if (len > 0 && val != NULL) {
-        uart_send_bytes_poll((const uint8_t *)val, len);
+    lat_record(LAT_LINK, batch->t_start, now);
+    for (uint8_t i = 0; i < batch->count; i++) {
+        lat_record(LAT_TOTAL, batch->t_ready[i], now);
     }
-
-    uart_send_u32_le_raw(FRAME_FTR);
 }
 
-static void uart_send_u32_le(uint8_t type, uint32_t v)
-{
-    uint8_t b[4];
-    b[0] = (uint8_t)(v & 0xFF);
-    b[1] = (uint8_t)((v >> 8) & 0xFF);
-    b[2] = (uint8_t)((v >> 16) & 0xFF);
-    b[3] = (uint8_t)((v >> 24) & 0xFF);
-    uart_send_tlv(type, b, 4);
-}
+#if !defined(CONFIG_PDM_BENCH)
+K_THREAD_STACK_DEFINE(capture_stack, CAPTURE_STACK_SIZE);
+static struct k_thread capture_thread_data;
+
+/*
+ * Stream restarts: stream_reconfigure() raises capture_stop_req, the
+ * capture thread stops the DMIC between two reads (so the request waits
+ * at most one block), parks, and starts over at sample index 0.
+ */
+static atomic_t capture_stop_req;
+static K_SEM_DEFINE(capture_parked, 0, 1);
+static K_SEM_DEFINE(capture_resume, 0, 1);
+
+/* The DMIC took neither the new nor the old config: capture stays parked */
+static bool capture_dead;
 
 /* ---------- Thread A: capture ---------- */
 static void capture_thread(void *p1, void *p2, void *p3)
 {
     const struct device *dmic = (const struct device *)p1;
+    uint64_t sample_idx = 0;
+
+    decim_reset();
+    level_reset();
+    ns_reset();
+    vad_reset();
 
     while (1) {
         void *buffer = NULL;
         size_t size = 0;
 
+        if (atomic_get(&capture_stop_req)) {
+            dmic_trigger(dmic, DMIC_TRIGGER_STOP);
+            k_sem_give(&capture_parked);
+            k_sem_take(&capture_resume, K_FOREVER);
+            sample_idx = 0;
+            decim_reset();
+            level_reset();
+            ns_reset();
+            vad_reset();
+        }
+
         /* Blocking read is OK: only this thread blocks */
         int ret = dmic_read(dmic, 0, &buffer, &size, 2000);
+        uint32_t t_ready = lat_now();
         if (ret) {
+            stats_dmic_error();
             printk("dmic_read err: %d\n", ret);
             continue;
         }
+        stats_block_captured();
+
+        /* DMIC blocks are at DECIM_FACTOR x rate_hz, from here on it's rate_hz */
+        const uint32_t frames = decim_block(buffer, size / stream_frame_bytes(), stream.channels);
+
+        size = frames * stream_frame_bytes();
+        level_dc(buffer, frames, stream.channels, stream.rate_hz);
+
+        uint32_t t_ns = k_cycle_get_32();
+
+        if (ns_block(buffer, frames, stream.channels)) {
+            stats_ns_block(k_cycle_get_32() - t_ns);
+        }
+
+        /* the trigger level is the microphone's, not the AGC's */
+        const bool loud = trigger_level(buffer, frames, stream.channels);
+
+        level_agc(buffer, frames, stream.channels, stream.rate_hz);
+        decim_half(buffer, frames, stream.channels,
+                   (int16_t *)((uint8_t *)buffer + SLAB_HALF_OFFSET(size)));
+
+#if !defined(CONFIG_PDM_TEST_PATTERN_NONE)
+        test_pattern_fill(buffer, frames, stream.channels, sample_idx);
+#endif
 
         struct audio_item item = {
-            .buf  = buffer,
-            .size = (uint16_t)size
+            .buf   = buffer,
+            .size  = (uint16_t)size,
+            .ts_ms = k_uptime_get_32() - stream.block_ms,
+            .first_sample = sample_idx,
+            .t_ready = t_ready,
+            .speech = vad_block(buffer, frames, stream.channels, stream.rate_hz),
+            .trigger = loud,
         };
 
-        /* If TX can't keep up, drop block safely */
-        ret = k_msgq_put(&audio_q, &item, K_NO_WAIT);
-        if (ret) {
-            k_mem_slab_free(&audio_slab, buffer);
-            /* optional: track drops */
-            // printk("audio_q full, dropped\n");
+        sample_idx += frames;
+
+        /* Never waits: a subscriber that can't keep up loses the block, on its own */
+        item.t_put = lat_now();
+        fanout_publish(&item);
+    }
+}
+#else
+/* ---------- Bench: stands in for the capture thread ---------- */
+static int bench_feed(void *buf, size_t size)
+{
+    static uint64_t sample_idx;
+    struct audio_item item = {
+        .buf   = buf,
+        .size  = (uint16_t)size,
+        .ts_ms = k_uptime_get_32(),
+        .first_sample = sample_idx,
+        .t_ready = lat_now(),
+        .speech = true,
+    };
+
+    item.t_put = item.t_ready;
+    sample_idx += size / stream_frame_bytes();
+
+    /* straight to TX, waiting for room: the bench measures throughput, not drops */
+    fanout_ref(buf);
+    return k_msgq_put(&audio_q, &item, K_FOREVER);
+}
+#endif
+
+/* ---------- VAD and trigger gating (TX thread only) ---------- */
+
+/*
+ * Silent blocks (CONFIG_PDM_VAD) wait in `held` as pre-roll. A speech block
+ * releases them ahead of itself, so the host also gets the onset the VAD
+ * needed a block or two to catch. Blocks pushed out of the pre-roll are
+ * freed and counted into a silence run, sent as one TLV_T_SILENCE. Without
+ * the VAD every block is speech and nothing is ever held.
+ *
+ * While the trigger is armed (CONFIG_PDM_TRIGGER) every block is held, up
+ * to the trigger pre-roll, and blocks pushed out are freed without a word
+ * to the host. The trigger releases the lot, VAD or not.
+ */
+#define HELD_MAX  (MAX(VAD_PREROLL_BLOCKS, TRIGGER_PREROLL_MAX) + 1)
+
+static struct audio_item held[HELD_MAX];
+static uint16_t held_head;
+static uint16_t held_len;
+static uint16_t held_release;  /* held blocks to send before reading audio_q again */
+static bool     held_armed;    /* trigger armed: what drops out of `held` goes unreported */
+
+static struct {
+    uint32_t ts_ms;
+    uint64_t first_sample;
+    uint16_t spb;
+    uint16_t blocks;
+} silence;
+
+static inline uint16_t item_spb(const struct audio_item *it)
+{
+    return it->size / stream_frame_bytes();
+}
+
+static void silence_send(void)
+{
+    uint8_t v[PCM_BATCH_HDR_BYTES + 2];
+
+    if (silence.blocks == 0) {
+        return;
+    }
+    sys_put_le32(silence.ts_ms, &v[0]);
+    sys_put_le16(silence.blocks, &v[4]);
+    sys_put_le16(silence.spb, &v[6]);
+    sys_put_le64(silence.first_sample, &v[8]);
+    sys_put_le16(vad_noise_floor_rms(), &v[16]);
+    tlv_link_send(TLV_T_SILENCE, v, sizeof(v));
+    stats_blocks_silent(silence.blocks);
+    silence.blocks = 0;
+}
+
+/* Frees the block; only its place in the timeline goes to the host */
+static void silence_add(const struct audio_item *it)
+{
+    if (silence.blocks != 0 &&
+        (item_spb(it) != silence.spb ||
+         it->first_sample != silence.first_sample + (uint64_t)silence.blocks * silence.spb)) {
+        silence_send();
+    }
+    if (silence.blocks == 0) {
+        silence.ts_ms = it->ts_ms;
+        silence.first_sample = it->first_sample;
+        silence.spb = item_spb(it);
+    }
+    silence.blocks++;
+    fanout_release(it->buf);
+
+    if (silence.blocks >= VAD_SILENCE_MAX_BLOCKS) {
+        silence_send();
+    }
+}
+
+static void held_push(const struct audio_item *it)
+{
+    held[(held_head + held_len) % HELD_MAX] = *it;
+    held_len++;
+}
+
+static void held_pop(struct audio_item *it)
+{
+    *it = held[held_head];
+    held_head = (held_head + 1) % HELD_MAX;
+    held_len--;
+}
+
+/* Out of the pre-roll: silence, or nothing at all while armed */
+static void held_drop(const struct audio_item *it)
+{
+    if (held_armed) {
+        fanout_release(it->buf);
+    } else {
+        silence_add(it);
+    }
+}
+
+/* Everything held turned out to be silence */
+static void held_flush(void)
+{
+    struct audio_item it;
+
+    while (held_len > 0) {
+        held_pop(&it);
+        held_drop(&it);
+    }
+}
+
+/* `it` continues the newest held block (no drop or restart in between) */
+static bool held_follows(const struct audio_item *it)
+{
+    if (held_len == 0) {
+        return true;
+    }
+    const struct audio_item *last = &held[(held_head + held_len - 1) % HELD_MAX];
+
+    return it->size == last->size && it->first_sample == last->first_sample + item_spb(last);
+}
+
+/*
+ * Next block to send, in capture order. Returns false if the block was
+ * held back or dropped as silence, or if no block came in for a few block
+ * lengths: then everything held is flushed as silence, so a stopped
+ * capture (stream_reconfigure) gets all its slab blocks back.
+ */
+static bool tx_next(struct audio_item *item)
+{
+    if (held_release > 0) {
+        held_release--;
+        held_pop(item);
+        return true;
+    }
+
+    k_timeout_t wait = (held_len > 0 || silence.blocks > 0) ? K_MSEC(4 * stream.block_ms)
+                                                           : K_FOREVER;
+
+    if (k_msgq_get(&audio_q, item, wait) != 0) {
+        held_flush();
+        silence_send();
+        return false;
+    }
+    if (!held_follows(item)) {
+        held_flush();
+    }
+
+    const enum trigger_gate gate = trigger_gate(item, stream.rate_hz);
+
+    if (gate == TRIGGER_FIRED) {
+        trigger_report(held_len > 0 ? held[held_head].first_sample : item->first_sample, held_len);
+    }
+    held_armed = (gate == TRIGGER_HOLD);
+    if (gate == TRIGGER_FIRED || (gate == TRIGGER_LIVE && item->speech)) {
+        if (held_len > 0) {
+            held_push(item);
+            held_pop(item);
+            held_release = held_len;
         }
+        /* the silence run ends before the pre-roll */
+        silence_send();
+        return true;
+    }
+
+    const uint16_t preroll = held_armed ? MIN(TRIGGER_PREROLL_BLOCKS(stream.block_ms), HELD_MAX - 1)
+                                        : VAD_PREROLL_BLOCKS;
+
+    if (held_armed) {
+        silence_send();
+    }
+    if (preroll == 0) {
+        held_drop(item);
+        return false;
+    }
+    /* a trigger pre-roll shrinks to the VAD's once live */
+    while (held_len >= preroll) {
+        struct audio_item oldest;
+
+        held_pop(&oldest);
+        held_drop(&oldest);
+    }
+    held_push(item);
+    return false;
+}
+
+/* The block tx_next() returns next, if it is already there and to be sent */
+static bool tx_peek(struct audio_item *next)
+{
+    if (held_release > 0) {
+        *next = held[held_head];
+        return true;
     }
+    return k_msgq_peek(&audio_q, next) == 0 && next->speech && trigger_streaming(next);
 }
 
 /* ---------- Thread B: TX ---------- */
@@ -135,41 +496,132 @@ static void tx_thread(void *p1, void *p2, void *p3)
 
     /* Optional: send a sync marker once at start */
     const char sync_str[] = "SYNC";
-    uart_send_tlv(TLV_T_SYNC, sync_str, (uint16_t)sizeof(sync_str) - 1);
+    tlv_link_send(TLV_T_SYNC, sync_str, (uint16_t)sizeof(sync_str) - 1);
+
+    uint8_t next_batch = 0;
+
+    pcm_codec_reset();
 
     while (1) {
         struct audio_item item;
-        k_msgq_get(&audio_q, &item, K_FOREVER);
 
-        /* Optional timestamp before each block (ms since boot) */
-        uint32_t ms = (uint32_t)k_uptime_get_32();
-        uart_send_u32_le(TLV_T_TIMESTAMP_MS, ms);
+        if (!tx_next(&item)) {
+            continue;
+        }
 
-        /* Send PCM block as TLV */
-        uart_send_tlv(TLV_T_PCM_BLOCK, item.buf, item.size);
+#if defined(CONFIG_PDM_BENCH)
+        uint64_t busy_t0 = bench_now_ns();
+#endif
+        struct pcm_batch *batch = &pcm_batches[next_batch];
+        struct tlv_seg segs[1 + CONFIG_PDM_BATCH_MAX_BLOCKS];
+        uint32_t t_get[CONFIG_PDM_BATCH_MAX_BLOCKS];
+
+        next_batch = (next_batch + 1) % ARRAY_SIZE(pcm_batches);
+
+        const uint16_t block_size = item.size;
+        const uint16_t spb        = block_size / stream_frame_bytes();
+        const uint32_t first_ts   = item.ts_ms;
+        const uint64_t first_idx  = item.first_sample;
+        const uint8_t  max_blocks = MIN(CONFIG_PDM_BATCH_MAX_BLOCKS,
+                                        (TLV_LINK_VALUE_MAX - PCM_BATCH_HDR_BYTES) /
+                                        BLOCK_WIRE_BYTES(block_size));
+
+        /*
+         * Coalesce whatever is already queued (or released as VAD pre-roll)
+         * behind this block: an idle queue sends one block per frame, a
+         * backed up one drains faster.
+         */
+        batch->count = 0;
+        do {
+            t_get[batch->count] = lat_now();
+            lat_record(LAT_CAPTURE, item.t_ready, item.t_put);
+            lat_record(LAT_QUEUE, item.t_put, t_get[batch->count]);
+
+            uint16_t len;
+            const void *enc = pcm_codec_encode(item.buf, item.size,
+                                               batch->enc[batch->count], &len);
+
+            batch->bufs[batch->count] = item.buf;
+            batch->t_ready[batch->count] = item.t_ready;
+            segs[1 + batch->count] = (struct tlv_seg){ enc, len };
+            batch->count++;
+
+            struct audio_item next;
+            if (batch->count == max_blocks ||
+                !tx_peek(&next) || next.size != block_size ||
+                next.first_sample != item.first_sample + spb) {
+                break;
+            }
+            /*
+             * The gate may still hold it back (the host re-armed since the
+             * peek): then tx_next() owns the block and the batch ends here.
+             */
+            if (!tx_next(&item)) {
+                break;
+            }
+        } while (1);
+
+        sys_put_le32(first_ts, &batch->hdr[0]);
+        sys_put_le16(batch->count, &batch->hdr[4]);
+        sys_put_le16(spb, &batch->hdr[6]);
+        sys_put_le64(first_idx, &batch->hdr[8]);
+        segs[0] = (struct tlv_seg){ batch->hdr, PCM_BATCH_HDR_BYTES };
+
+#if defined(CONFIG_PDM_BENCH)
+        /* waiting for a free tlv_link job is back-pressure, not TX work */
+        uint64_t busy = bench_now_ns() - busy_t0;
+
+        tlv_link_wait_slot();
+        busy_t0 = bench_now_ns();
+#endif
+
+#if defined(CONFIG_PDM_DECIM_HALF_RATE)
+        /*
+         * Same blocks, half rate, from the slab block tails. Frames leave in
+         * order, so the slab blocks outlive it: pcm_batch_done() frees them.
+         */
+        struct tlv_seg half_segs[1 + CONFIG_PDM_BATCH_MAX_BLOCKS];
+
+        sys_put_le32(first_ts, &batch->half_hdr[0]);
+        sys_put_le16(batch->count, &batch->half_hdr[4]);
+        sys_put_le16(spb / 2, &batch->half_hdr[6]);
+        sys_put_le64(first_idx / 2, &batch->half_hdr[8]);
+        half_segs[0] = (struct tlv_seg){ batch->half_hdr, PCM_BATCH_HDR_BYTES };
+        for (uint8_t i = 0; i < batch->count; i++) {
+            half_segs[1 + i] = (struct tlv_seg){
+                (const uint8_t *)batch->bufs[i] + SLAB_HALF_OFFSET(block_size),
+                DECIM_HALF_BYTES(block_size),
+            };
+        }
+        tlv_link_send_segs(TLV_T_PCM_HALF_BATCH, half_segs, 1 + batch->count, NULL, NULL);
+#endif
 
-        /* Free buffer after sending */
-        k_mem_slab_free(&audio_slab, item.buf);
-    }
-}
+        batch->t_start = lat_now();
+        for (uint8_t i = 0; i < batch->count; i++) {
+            lat_record(LAT_ENCODE, t_get[i], batch->t_start);
+        }
 
-int main(void)
-{
-    const struct device *dmic = DEVICE_DT_GET(DT_ALIAS(appmic));
-    if (!device_is_ready(dmic)) {
-        printk("DMIC device not ready\n");
-        return 0;
+        /*
+         * Slab blocks are freed once tlv_link is done with them, the latency
+         * is taken when the batch is on the wire. The batch itself is reused
+         * only after TLV_LINK_JOBS more frames, so it outlives both.
+         */
+        tlv_link_send_segs_wire(pcm_codec_tlv_type(), segs, 1 + batch->count,
+                                pcm_batch_done, pcm_batch_on_wire, batch);
+#if defined(CONFIG_PDM_BENCH)
+        bench_tx_busy(busy + bench_now_ns() - busy_t0);
+#endif
     }
+}
 
-    uart_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
-    if (!device_is_ready(uart_dev)) {
-        printk("UART console not ready\n");
-        return 0;
-    }
+#if !defined(CONFIG_PDM_BENCH)
+/* ---------- Stream configuration ---------- */
 
-    printk("DMIC + UART ready. %d Hz, %d-bit, %dch, block=%d bytes\n",
-           SAMPLE_RATE_HZ, PCM_WIDTH_BITS, CHANNELS, BLOCK_SIZE_BYTES);
+/* TLV_T_STREAM_CFG requests, handed from the RX thread to main() */
+K_MSGQ_DEFINE(stream_cfg_q, sizeof(struct pdm_stream_cfg), 2, 4);
 
+static int dmic_setup(const struct device *dmic, const struct pdm_stream_cfg *c)
+{
     static struct pcm_stream_cfg stream_cfg[1];
     struct dmic_cfg cfg;
     memset(&cfg, 0, sizeof(cfg));
@@ -181,17 +633,237 @@ int main(void)
     cfg.io.max_pdm_clk_dc   = 60;
 
     cfg.channel.req_num_streams = 1;
-    cfg.channel.req_num_chan = CHANNELS;
+    cfg.channel.req_num_chan = c->channels;
     cfg.channel.req_chan_map_lo = dmic_build_channel_map(0, 0, PDM_CHAN_LEFT);
+    if (c->channels > 1) {
+        cfg.channel.req_chan_map_lo |= dmic_build_channel_map(1, 0, PDM_CHAN_RIGHT);
+    }
     cfg.channel.req_chan_map_hi = 0;
 
     cfg.streams = stream_cfg;
-    cfg.streams[0].pcm_rate   = SAMPLE_RATE_HZ;
-    cfg.streams[0].pcm_width  = PCM_WIDTH_BITS;
-    cfg.streams[0].block_size = BLOCK_SIZE_BYTES;
+    cfg.streams[0].pcm_rate   = c->rate_hz * DECIM_FACTOR;
+    cfg.streams[0].pcm_width  = c->width_bits;
+    cfg.streams[0].block_size = pdm_stream_capture_bytes(c);
     cfg.streams[0].mem_slab   = &audio_slab;
 
-    int ret = dmic_configure(dmic, &cfg);
+    return dmic_configure(dmic, &cfg);
+}
+
+static int stream_cfg_check(const struct pdm_stream_cfg *c)
+{
+    /* codecs, test patterns and the host all work on int16 */
+    if (c->width_bits != 16) {
+        return -ENOTSUP;
+    }
+    /* ADPCM / lossless / spectrum / MFCC work on one sample stream: mono only */
+    if (c->channels > 1 && !IS_ENABLED(CONFIG_PDM_CODEC_RAW)) {
+        return -ENOTSUP;
+    }
+    /* the DMIC runs at DECIM_FACTOR x rate_hz */
+    if (c->channels == 0 || c->channels > CHANNELS_MAX ||
+        c->rate_hz * DECIM_FACTOR < 8000 || c->rate_hz * DECIM_FACTOR > 96000 ||
+        c->block_ms == 0 || (c->rate_hz * c->block_ms) % 1000 != 0) {
+        return -EINVAL;
+    }
+    if (IS_ENABLED(CONFIG_PDM_DECIM_HALF_RATE) && pdm_stream_spb(c) % 2 != 0) {
+        return -EINVAL;
+    }
+    if (PCM_CODEC_RATE_HZ != 0 && c->rate_hz != PCM_CODEC_RATE_HZ) {
+        return -ENOTSUP;
+    }
+    if (pdm_stream_block_bytes(c) < PCM_CODEC_MIN_BLOCK_BYTES) {
+        return -EINVAL;
+    }
+    if (pdm_stream_block_bytes(c) > BLOCK_MAX_BYTES ||
+        audio_slab_blocks(c) < POOL_MIN_BLOCKS(c->block_ms)) {
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+static void stream_cfg_ack(int status)
+{
+    uint8_t v[16];
+
+    sys_put_le32((uint32_t)status, &v[0]);
+    sys_put_le32(stream.rate_hz, &v[4]);
+    sys_put_le16(stream.block_ms, &v[8]);
+    v[10] = stream.channels;
+    v[11] = stream.width_bits;
+    sys_put_le16(pdm_stream_block_bytes(&stream), &v[12]);
+    sys_put_le16(k_mem_slab_num_free_get(&audio_slab) + k_mem_slab_num_used_get(&audio_slab), &v[14]);
+    tlv_link_send(TLV_T_STREAM_CFG_ACK, v, sizeof(v));
+}
+
+/*
+ * Stop capture, wait for every block of the old config to come back
+ * (TX queue, tlv_link, DMIC driver), re-carve the pool, reconfigure and
+ * restart. A config the DMIC refuses falls back to the previous one; if
+ * that fails too, the error is returned and capture stays stopped until a
+ * later request configures the DMIC.
+ */
+static int stream_reconfigure(const struct device *dmic, const struct pdm_stream_cfg *req)
+{
+    const struct pdm_stream_cfg old = stream;
+    int ret = stream_cfg_check(req);
+
+    if (ret) {
+        return ret;
+    }
+    if (!capture_dead && memcmp(req, &stream, sizeof(stream)) == 0) {
+        return 0;
+    }
+
+    /* bounded: dmic_read() in the capture thread gives up after 2 s */
+    if (!capture_dead) {
+        atomic_set(&capture_stop_req, 1);
+        k_sem_take(&capture_parked, K_FOREVER);
+    }
+
+    for (int i = 0; k_mem_slab_num_used_get(&audio_slab) != 0; i++) {
+        void *buf;
+        size_t size;
+
+        /* the driver may complete one more block after STOP */
+        while (dmic_read(dmic, 0, &buf, &size, 0) == 0) {
+            k_mem_slab_free(&audio_slab, buf);
+        }
+        if (i == 200) {
+            /* blocks still out: the pool can't be re-carved, carry on as before */
+            ret = -EBUSY;
+            goto restart;
+        }
+        k_sleep(K_MSEC(5));
+    }
+
+    audio_slab_carve(req);
+    ret = dmic_setup(dmic, req);
+    if (ret == 0) {
+        stream = *req;
+    } else {
+        audio_slab_carve(&old);
+        int err = dmic_setup(dmic, &old);
+
+        if (err) {
+            /* nothing to capture with: stay parked until a request works */
+            printk("dmic_configure failed: %d, old config too: %d\n", ret, err);
+            capture_dead = true;
+            return err;
+        }
+    }
+    capture_dead = false;
+    /* TX is idle on an empty audio_q: the first block after this is a new stream */
+    pcm_codec_reset();
+    stats_slab_reset();
+
+restart:
+    dmic_trigger(dmic, DMIC_TRIGGER_START);
+    atomic_clear(&capture_stop_req);
+    k_sem_give(&capture_resume);
+    return ret;
+}
+
+/* Zero fields of a TLV_T_STREAM_CFG keep the current value; empty = query */
+static void stream_cfg_request(const uint8_t *val, uint16_t len)
+{
+    struct pdm_stream_cfg req = { 0 };
+
+    if (len >= 8) {
+        req.rate_hz    = sys_get_le32(&val[0]);
+        req.block_ms   = sys_get_le16(&val[4]);
+        req.channels   = val[6];
+        req.width_bits = val[7];
+    }
+    k_msgq_put(&stream_cfg_q, &req, K_NO_WAIT);
+}
+
+static void stream_cfg_service(const struct device *dmic, k_timeout_t timeout)
+{
+    struct pdm_stream_cfg req;
+
+    if (k_msgq_get(&stream_cfg_q, &req, timeout) != 0) {
+        return;
+    }
+    req.rate_hz    = req.rate_hz ? req.rate_hz : stream.rate_hz;
+    req.block_ms   = req.block_ms ? req.block_ms : stream.block_ms;
+    req.channels   = req.channels ? req.channels : stream.channels;
+    req.width_bits = req.width_bits ? req.width_bits : stream.width_bits;
+
+    stream_cfg_ack(stream_reconfigure(dmic, &req));
+}
+#endif
+
+/* ---------- Host -> device frames (tlv_link RX thread) ---------- */
+static void ctrl_rx(uint8_t type, const uint8_t *val, uint16_t len)
+{
+    link_rate_rx(type, val, len);
+
+    switch (type) {
+    case TLV_T_LAT_DUMP:
+        lat_dump(len > 0 && (val[0] & BIT(0)));
+        break;
+    case TLV_T_NS_CTRL:
+        if (len >= 1) {
+            ns_set_enabled(val[0] != 0);
+        }
+        break;
+    case TLV_T_TRIGGER_CTRL:
+        if (len >= 1 && val[0] != 0) {
+            trigger_fire(TRIGGER_SRC_HOST);
+        } else if (len >= 1) {
+            trigger_arm();
+        }
+        break;
+#if !defined(CONFIG_PDM_BENCH)
+    case TLV_T_STREAM_CFG:
+        stream_cfg_request(val, len);
+        break;
+#endif
+    default:
+        break;
+    }
+}
+
+int main(void)
+{
+    const struct device *uart_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+    if (!device_is_ready(uart_dev)) {
+        printk("UART console not ready\n");
+        return 0;
+    }
+    tlv_link_init(uart_dev);
+    link_rate_init();
+    tlv_link_rx_start(ctrl_rx);
+    audio_slab_carve(&stream);
+    fanout_subscribe(&tx_sub);
+#if !defined(CONFIG_PDM_BENCH)
+    meter_start();
+#endif
+
+    int ret = trigger_init();
+    if (ret && ret != -ENOTSUP) {
+        printk("trigger button: %d\n", ret);
+    }
+
+#if defined(CONFIG_PDM_BENCH)
+    k_thread_create(&tx_thread_data, tx_stack, TX_STACK_SIZE,
+                    tx_thread, NULL, NULL, NULL,
+                    TX_PRIO, 0, K_NO_WAIT);
+
+    bench_run(&audio_slab, BLOCK_SIZE_BYTES, bench_feed);
+    return 0;
+#else
+    const struct device *dmic = DEVICE_DT_GET(DT_ALIAS(appmic));
+    if (!device_is_ready(dmic)) {
+        printk("DMIC device not ready\n");
+        return 0;
+    }
+
+    printk("DMIC + UART ready. %d Hz, %d-bit, %dch, block=%d bytes, tx=%s\n",
+           SAMPLE_RATE_HZ, PCM_WIDTH_BITS, CHANNELS, BLOCK_SIZE_BYTES,
+           tlv_link_get_mode() == TLV_LINK_MODE_ASYNC ? "async" : "poll");
+
+    ret = dmic_setup(dmic, &stream);
     if (ret) {
         printk("dmic_configure failed: %d\n", ret);
         return 0;
@@ -203,15 +875,36 @@ int main(void)
         return 0;
     }
 
-    k_thread_create(&capture_thread_data, capture_stack, CAPTURE_STACK_SIZE,
-                    capture_thread, (void *)dmic, NULL, NULL,
-                    CAPTURE_PRIO, 0, K_NO_WAIT);
+    k_tid_t capture_tid = k_thread_create(&capture_thread_data, capture_stack,
+                                          CAPTURE_STACK_SIZE, capture_thread,
+                                          (void *)dmic, NULL, NULL,
+                                          CAPTURE_PRIO, 0, K_FOREVER);
 
-    k_thread_create(&tx_thread_data, tx_stack, TX_STACK_SIZE,
-                    tx_thread, NULL, NULL, NULL,
-                    TX_PRIO, 0, K_NO_WAIT);
+    k_tid_t tx_tid = k_thread_create(&tx_thread_data, tx_stack, TX_STACK_SIZE,
+                                     tx_thread, NULL, NULL, NULL,
+                                     TX_PRIO, 0, K_FOREVER);
+
+    stats_init(&audio_q, &audio_slab, capture_tid, tx_tid);
+    k_thread_start(capture_tid);
+    k_thread_start(tx_tid);
+
+#if defined(CONFIG_PDM_STATS)
+    const int64_t period_ms = CONFIG_PDM_STATS_PERIOD_MS;
+#else
+    const int64_t period_ms = 1000;
+#endif
+    int64_t next_emit = k_uptime_get() + period_ms;
 
+    /* Stream config requests are served between stats reports */
     while (1) {
-        k_sleep(K_SECONDS(1));
+        int64_t now = k_uptime_get();
+
+        if (now < next_emit) {
+            stream_cfg_service(dmic, K_MSEC(next_emit - now));
+            continue;
+        }
+        next_emit = now + period_ms;
+        stats_emit();
     }
+#endif
 }
@@ -0,0 +1,60 @@
+#ifndef PDM_CFG_H_
+#define PDM_CFG_H_
+
+#include <stdint.h>
+
+/*
+ * The DMIC captures at DECIM_FACTOR times the stream rate; decim_block()
+ * (decim.h) brings each block down before anything else sees it. Rates and
+ * block sizes below are the stream's, i.e. what goes to the host.
+ */
+#define DECIM_FACTOR        CONFIG_PDM_DECIM_FACTOR
+
+/*
+ * Audio config, shared by main.c and the processing modules.
+ * These are the power-on defaults; the host can change rate, block length
+ * and channels at runtime (TLV_T_STREAM_CFG), see pdm_stream_cfg_get().
+ */
+#define CAPTURE_RATE_HZ     16000
+#define SAMPLE_RATE_HZ      (CAPTURE_RATE_HZ / DECIM_FACTOR)
+#define PCM_WIDTH_BITS      16
+#define CHANNELS            1
+
+#define BLOCK_MS            20
+#define SAMPLES_PER_BLOCK   ((SAMPLE_RATE_HZ * BLOCK_MS) / 1000)   /* 320 at 16 kHz */
+#define BYTES_PER_SAMPLE    (PCM_WIDTH_BITS / 8)                   /* 2   */
+#define BLOCK_SIZE_BYTES    (SAMPLES_PER_BLOCK * BYTES_PER_SAMPLE * CHANNELS)
+
+/* Runtime limits; buffers are sized for these */
+#define CHANNELS_MAX        2
+#define BLOCK_MAX_BYTES     CONFIG_PDM_BLOCK_MAX_BYTES
+#define SAMPLES_PER_BLOCK_MAX (BLOCK_MAX_BYTES / BYTES_PER_SAMPLE)  /* all channels */
+
+struct pdm_stream_cfg {
+    uint32_t rate_hz;
+    uint16_t block_ms;
+    uint8_t  channels;
+    uint8_t  width_bits;
+};
+
+/* Samples per channel in one block */
+static inline uint32_t pdm_stream_spb(const struct pdm_stream_cfg *c)
+{
+    return c->rate_hz * c->block_ms / 1000u;
+}
+
+static inline uint32_t pdm_stream_block_bytes(const struct pdm_stream_cfg *c)
+{
+    return pdm_stream_spb(c) * (c->width_bits / 8u) * c->channels;
+}
+
+/* What the DMIC fills per block: DECIM_FACTOR stream blocks' worth */
+static inline uint32_t pdm_stream_capture_bytes(const struct pdm_stream_cfg *c)
+{
+    return pdm_stream_block_bytes(c) * DECIM_FACTOR;
+}
+
+/* Active stream config (main.c); only changes while capture is stopped */
+const struct pdm_stream_cfg *pdm_stream_cfg_get(void);
+
+#endif // PDM_CFG_H_
@@ -0,0 +1,19 @@
+#ifndef PDM_SIMD_H_
+#define PDM_SIMD_H_
+
+/*
+ * PDM_SIMD is 1 when the audio kernels may use the Arm DSP extension
+ * (SMUAD, QADD16, ... on packed int16 pairs): CONFIG_PDM_SIMD and a core
+ * the compiler targets with it (__ARM_FEATURE_DSP: Cortex-M4/M7/M33/M55).
+ * Everything else (Cortex-M0/M3, RISC-V, Xtensa, native_sim) builds the
+ * portable C kernels, which stay compiled in next to the DSP ones so the
+ * bench can check them against each other.
+ */
+#if defined(CONFIG_PDM_SIMD) && defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include <cmsis_core.h>
+#define PDM_SIMD 1
+#else
+#define PDM_SIMD 0
+#endif
+
+#endif // PDM_SIMD_H_
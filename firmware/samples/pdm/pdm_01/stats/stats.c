@@ -0,0 +1,154 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include "stats.h"
+#include "tlv_link.h"
+#include "meter.h"
+
+static struct k_msgq *stats_q;
+static struct k_mem_slab *stats_slab;
+static k_tid_t stats_capture_tid;
+static k_tid_t stats_tx_tid;
+
+static atomic_t blocks_captured;
+static atomic_t blocks_dropped;
+static atomic_t dmic_errors;
+static atomic_t blocks_silent;
+
+/* Noise suppressor cost since the last emit */
+static atomic_t ns_cycles;
+static atomic_t ns_blocks;
+
+/* Only written by the capture thread */
+static uint16_t q_hwm;
+static uint16_t slab_min_free;
+
+/* Previous emit, for rates */
+static int64_t  last_ms;
+static uint32_t last_tx_bytes;
+static uint64_t last_capture_cycles;
+static uint64_t last_tx_cycles;
+
+static uint64_t thread_cycles(k_tid_t tid)
+{
+    k_thread_runtime_stats_t st;
+
+    if (tid == NULL || k_thread_runtime_stats_get(tid, &st) != 0) {
+        return 0;
+    }
+    return st.execution_cycles;
+}
+
+static uint16_t cpu_permille(uint64_t cycles, int64_t wall_ms)
+{
+    if (wall_ms <= 0) {
+        return 0;
+    }
+    uint64_t us = k_cyc_to_us_floor64(cycles);
+    return (uint16_t)MIN(us / (uint64_t)wall_ms, 1000u);
+}
+
+void stats_init(struct k_msgq *q, struct k_mem_slab *slab,
+                k_tid_t capture_tid, k_tid_t tx_tid)
+{
+    stats_q = q;
+    stats_slab = slab;
+    stats_capture_tid = capture_tid;
+    stats_tx_tid = tx_tid;
+
+    q_hwm = 0;
+    slab_min_free = (uint16_t)k_mem_slab_num_free_get(slab);
+
+    last_ms = k_uptime_get();
+    last_tx_bytes = tlv_link_bytes_sent();
+    last_capture_cycles = thread_cycles(capture_tid);
+    last_tx_cycles = thread_cycles(tx_tid);
+}
+
+void stats_slab_reset(void)
+{
+    slab_min_free = (uint16_t)k_mem_slab_num_free_get(stats_slab);
+}
+
+void stats_block_captured(void)
+{
+    atomic_inc(&blocks_captured);
+
+    uint16_t used = (uint16_t)k_msgq_num_used_get(stats_q);
+    uint16_t free_blocks = (uint16_t)k_mem_slab_num_free_get(stats_slab);
+
+    if (used > q_hwm) {
+        q_hwm = used;
+    }
+    if (free_blocks < slab_min_free) {
+        slab_min_free = free_blocks;
+    }
+}
+
+void stats_block_dropped(void)
+{
+    atomic_inc(&blocks_dropped);
+}
+
+void stats_dmic_error(void)
+{
+    atomic_inc(&dmic_errors);
+}
+
+void stats_blocks_silent(uint32_t n)
+{
+    atomic_add(&blocks_silent, (atomic_val_t)n);
+}
+
+void stats_ns_block(uint32_t cycles)
+{
+    atomic_add(&ns_cycles, (atomic_val_t)cycles);
+    atomic_inc(&ns_blocks);
+}
+
+void stats_emit(void)
+{
+    uint8_t v[STATS_TLV_BYTES];
+    int64_t now = k_uptime_get();
+    int64_t dt  = now - last_ms;
+
+    uint32_t tx_bytes = tlv_link_bytes_sent();
+    uint64_t cap_cyc  = thread_cycles(stats_capture_tid);
+    uint64_t tx_cyc   = thread_cycles(stats_tx_tid);
+
+    uint32_t ns_n   = (uint32_t)atomic_clear(&ns_blocks);
+    uint32_t ns_cyc = (uint32_t)atomic_clear(&ns_cycles);
+
+    uint16_t level_peak, level_rms;
+    uint32_t meter_dropped;
+
+    meter_take(&level_peak, &level_rms, &meter_dropped);
+
+    uint32_t tx_rate = (dt > 0) ? (uint32_t)(((uint64_t)(tx_bytes - last_tx_bytes) * 1000u) / dt) : 0;
+
+    sys_put_le32((uint32_t)now, &v[0]);
+    sys_put_le32((uint32_t)atomic_get(&blocks_captured), &v[4]);
+    sys_put_le32((uint32_t)atomic_get(&blocks_dropped), &v[8]);
+    sys_put_le32((uint32_t)atomic_get(&dmic_errors), &v[12]);
+    sys_put_le16(q_hwm, &v[16]);
+    sys_put_le16((uint16_t)k_msgq_num_used_get(stats_q), &v[18]);
+    sys_put_le16(slab_min_free, &v[20]);
+    sys_put_le16((uint16_t)(k_mem_slab_num_free_get(stats_slab) +
+                            k_mem_slab_num_used_get(stats_slab)), &v[22]);
+    sys_put_le32(tx_rate, &v[24]);
+    sys_put_le16(cpu_permille(cap_cyc - last_capture_cycles, dt), &v[28]);
+    sys_put_le16(cpu_permille(tx_cyc - last_tx_cycles, dt), &v[30]);
+    sys_put_le32((uint32_t)atomic_get(&blocks_silent), &v[32]);
+    sys_put_le32(ns_n ? ns_cyc / ns_n : 0, &v[36]);
+    sys_put_le32(sys_clock_hw_cycles_per_sec(), &v[40]);
+    sys_put_le16(level_peak, &v[44]);
+    sys_put_le16(level_rms, &v[46]);
+    sys_put_le32(meter_dropped, &v[48]);
+
+    last_ms = now;
+    last_tx_bytes = tx_bytes;
+    last_capture_cycles = cap_cyc;
+    last_tx_cycles = tx_cyc;
+
+    tlv_link_send(TLV_T_STATS, v, sizeof(v));
+}
@@ -0,0 +1,63 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Pipeline health counters, sent as a periodic TLV_T_STATS frame.
+ * Value (all LE), fields are only ever appended:
+ *   uptime_ms(4) blocks_captured(4) blocks_dropped(4) dmic_errors(4)
+ *   audio_q_hwm(2) audio_q_len(2) slab_min_free(2) slab_blocks(2)
+ *   tx_bytes_per_s(4) cpu_capture_permille(2) cpu_tx_permille(2)
+ *   blocks_silent(4) ns_cycles_per_block(4) cycles_per_s(4)
+ *   level_peak(2) level_rms(2) meter_dropped(4)
+ *
+ * ns_cycles_per_block is the noise suppressor's average over the period
+ * (0 while it is off); cycles_per_s converts it to time. level_peak and
+ * level_rms are the meter's (meter.h) over the period, int16 units, 0
+ * without CONFIG_PDM_METER.
+ */
+#define STATS_TLV_BYTES  52
+
+#if defined(CONFIG_PDM_STATS)
+void stats_init(struct k_msgq *q, struct k_mem_slab *slab,
+                k_tid_t capture_tid, k_tid_t tx_tid);
+
+/* Capture thread hooks */
+void stats_block_captured(void);   /* also samples audio_q / audio_slab levels */
+void stats_block_dropped(void);
+void stats_dmic_error(void);
+
+/* TX thread: n blocks were reported as TLV_T_SILENCE instead of sent */
+void stats_blocks_silent(uint32_t n);
+
+/* Capture thread: ns_block() took this many cycles on one block */
+void stats_ns_block(uint32_t cycles);
+
+/* audio_slab was re-carved (stream reconfig): restart slab_min_free */
+void stats_slab_reset(void);
+
+/* Builds and sends one TLV_T_STATS frame; call once per period */
+void stats_emit(void);
+#else
+static inline void stats_init(struct k_msgq *q, struct k_mem_slab *slab,
+                              k_tid_t capture_tid, k_tid_t tx_tid) {}
+static inline void stats_block_captured(void) {}
+static inline void stats_block_dropped(void) {}
+static inline void stats_dmic_error(void) {}
+static inline void stats_blocks_silent(uint32_t n) {}
+static inline void stats_ns_block(uint32_t cycles) {}
+static inline void stats_slab_reset(void) {}
+static inline void stats_emit(void) {}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STATS_H_
@@ -0,0 +1,58 @@
+#ifndef TEST_PATTERN_H_
+#define TEST_PATTERN_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Deterministic replacement for the microphone samples, for link testing
+ * (host side: python/pdm/pdm_link_verify.py). Every sample is a pure
+ * function of its running sample index, so the host can check any frame
+ * on its own, also right after a gap or a resync.
+ *
+ *   counter: (int16_t)n
+ *   hash   : low 16 bits of lowbias32(lo32(n) ^ hi32(n)), white-looking
+ *            bits that exercise every bit position of the link
+ */
+static inline int16_t test_pattern_counter(uint64_t n)
+{
+    return (int16_t)n;
+}
+
+static inline int16_t test_pattern_hash(uint64_t n)
+{
+    uint32_t x = (uint32_t)n ^ (uint32_t)(n >> 32);
+
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return (int16_t)x;
+}
+
+/* Overwrite frames of interleaved PCM, first frame has index first */
+static inline void test_pattern_fill(int16_t *pcm, size_t frames, uint8_t channels,
+                                     uint64_t first)
+{
+    for (size_t i = 0; i < frames; i++) {
+#if defined(CONFIG_PDM_TEST_PATTERN_HASH)
+        int16_t s = test_pattern_hash(first + i);
+#else
+        int16_t s = test_pattern_counter(first + i);
+#endif
+        for (uint8_t c = 0; c < channels; c++) {
+            *pcm++ = s;
+        }
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_PATTERN_H_
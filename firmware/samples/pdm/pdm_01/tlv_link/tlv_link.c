@@ -0,0 +1,712 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/sys/crc.h>
+#include <string.h>
+#include <errno.h>
+#include "tlv_link.h"
+
+#define TLV_HDR_BYTES  7   /* FRAME_HDR(4) + T(1) + L(2) */
+#define TLV_FTR_BYTES  4
+
+#if defined(CONFIG_PDM_FRAMING_COBS)
+#define COBS_TL_BYTES   3   /* T(1) + L(2) */
+#define COBS_CRC_BYTES  4
+#define COBS_RAW_MAX(v) (COBS_TL_BYTES + (v) + COBS_CRC_BYTES)
+/* One code byte per started 254 byte run, plus the 0x00 delimiter */
+#define COBS_ENC_MAX(v) (COBS_RAW_MAX(v) + COBS_RAW_MAX(v) / 254 + 2)
+#endif
+
+struct tlv_job {
+#if defined(CONFIG_PDM_FRAMING_COBS)
+    uint8_t  frame[COBS_ENC_MAX(TLV_LINK_VALUE_MAX)];
+#else
+    uint8_t  hdr[TLV_HDR_BYTES];
+    uint8_t  ftr[TLV_FTR_BYTES];
+#endif
+    uint8_t  inline_buf[TLV_LINK_INLINE_MAX];
+    struct tlv_seg chunks[TLV_LINK_MAX_SEGS + 2];   /* hdr + segs + ftr */
+    uint8_t  nchunks;
+    uint8_t  cur;
+    tlv_link_done_cb done;
+    tlv_link_done_cb on_wire;
+    void    *user;
+};
+
+static const struct device *uart_dev;
+static enum tlv_link_mode link_mode = TLV_LINK_MODE_POLL;
+static atomic_t link_bytes_sent;
+
+/* Producers (tx thread, control replies, ...) are serialised here */
+K_MUTEX_DEFINE(link_mutex);
+
+static struct tlv_job poll_job;
+
+#if defined(CONFIG_PDM_UART_TX_ASYNC)
+static struct tlv_job jobs[TLV_LINK_JOBS];
+static uint8_t job_head;      /* in flight (owned by the ISR while busy) */
+static uint8_t job_tail;      /* next free slot (owned by producers) */
+static uint8_t job_pending;
+static struct k_spinlock job_lock;
+K_SEM_DEFINE(job_free, TLV_LINK_JOBS, TLV_LINK_JOBS);
+#endif
+
+#if defined(CONFIG_PDM_TLV_RX)
+#define RX_STACK_SIZE   1024
+#define RX_PRIO         6       /* below the TX thread */
+#define RX_POLL_MS      5       /* poll backend: idle sleep between bytes */
+
+#if defined(CONFIG_PDM_FRAMING_COBS)
+struct rx_parser {
+    uint16_t pos;
+    bool     overflow;
+    uint8_t  buf[COBS_ENC_MAX(TLV_LINK_RX_MAX)];
+};
+#else
+enum rx_state {
+    RX_HUNT = 0,    /* sliding 4 byte window looking for FRAME_HDR */
+    RX_TYPE,
+    RX_LEN0,
+    RX_LEN1,
+    RX_VAL,
+    RX_FTR,
+};
+
+struct rx_parser {
+    enum rx_state state;
+    uint32_t win;
+    uint8_t  type;
+    uint16_t len;
+    uint16_t pos;
+    uint8_t  val[TLV_LINK_RX_MAX];
+};
+#endif
+
+K_THREAD_STACK_DEFINE(rx_stack, RX_STACK_SIZE);
+static struct k_thread rx_thread_data;
+static struct rx_parser rx;
+static tlv_link_rx_cb rx_cb;
+
+#if defined(CONFIG_PDM_UART_TX_ASYNC)
+#define RX_DMA_BYTES    32
+#define RX_TIMEOUT_US   1000    /* flush partial DMA buffers after 1 ms idle */
+
+static uint8_t rx_dma[2][RX_DMA_BYTES];
+static uint8_t rx_dma_next;
+static bool rx_async;
+static bool rx_hold;            /* RX stopped on purpose (baud change) */
+RING_BUF_DECLARE(rx_ring, 256);
+K_SEM_DEFINE(rx_ready, 0, 1);
+K_SEM_DEFINE(rx_stopped, 0, 1);
+#endif
+#endif /* CONFIG_PDM_TLV_RX */
+
+/* ---------- frame building ---------- */
+static size_t segs_total(const struct tlv_seg *segs, size_t nsegs)
+{
+    size_t total = 0;
+
+    for (size_t i = 0; i < nsegs; i++) {
+        if (segs[i].data != NULL) {
+            total += segs[i].len;
+        }
+    }
+    return total;
+}
+
+#if defined(CONFIG_PDM_FRAMING_COBS)
+/*
+ * COBS: every 0x00 of the raw frame is replaced by the distance to the
+ * next one, so 0x00 only ever appears as the frame delimiter.
+ */
+struct cobs_enc {
+    uint8_t *out;
+    uint8_t *code_p;    /* where the current run's code byte goes */
+    uint8_t  code;      /* run length + 1 */
+};
+
+static inline void cobs_begin(struct cobs_enc *e, uint8_t *buf)
+{
+    e->code_p = buf;
+    e->out = buf + 1;
+    e->code = 1;
+}
+
+static void cobs_put(struct cobs_enc *e, const uint8_t *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (p[i] != 0) {
+            *e->out++ = p[i];
+            if (++e->code != 0xFF) {
+                continue;
+            }
+        }
+        *e->code_p = e->code;
+        e->code_p = e->out++;
+        e->code = 1;
+    }
+}
+
+static inline uint8_t *cobs_end(struct cobs_enc *e)
+{
+    *e->code_p = e->code;
+    *e->out++ = 0x00;
+    return e->out;
+}
+
+/*
+ * COBS(T(1) + L(2 LE) + V(L) + CRC32(4 LE)) + 0x00, CRC-32/IEEE over T..V.
+ * The value is copied into the job, so done() runs right away; on_wire()
+ * still waits for the frame to leave the UART.
+ */
+static size_t job_fill(struct tlv_job *job, uint8_t type,
+                       const struct tlv_seg *segs, size_t nsegs,
+                       tlv_link_done_cb done, tlv_link_done_cb on_wire, void *user)
+{
+    size_t total = segs_total(segs, nsegs);
+    uint8_t tl[COBS_TL_BYTES] = { type, (uint8_t)(total & 0xFF), (uint8_t)(total >> 8) };
+    uint8_t crc_le[COBS_CRC_BYTES];
+    uint32_t crc = crc32_ieee_update(0, tl, sizeof(tl));
+    struct cobs_enc e;
+
+    cobs_begin(&e, job->frame);
+    cobs_put(&e, tl, sizeof(tl));
+    for (size_t i = 0; i < nsegs; i++) {
+        if (segs[i].data == NULL || segs[i].len == 0) {
+            continue;
+        }
+        crc = crc32_ieee_update(crc, segs[i].data, segs[i].len);
+        cobs_put(&e, segs[i].data, segs[i].len);
+    }
+    sys_put_le32(crc, crc_le);
+    cobs_put(&e, crc_le, sizeof(crc_le));
+
+    size_t len = cobs_end(&e) - job->frame;
+
+    job->chunks[0] = (struct tlv_seg){ job->frame, (uint16_t)len };
+    job->nchunks = 1;
+    job->cur = 0;
+    job->done = NULL;
+    job->on_wire = on_wire;
+    job->user = user;
+    if (done) {
+        done(user);
+    }
+
+    atomic_add(&link_bytes_sent, (atomic_val_t)len);
+    return total;
+}
+#else
+static size_t job_fill(struct tlv_job *job, uint8_t type,
+                       const struct tlv_seg *segs, size_t nsegs,
+                       tlv_link_done_cb done, tlv_link_done_cb on_wire, void *user)
+{
+    size_t total = 0;
+
+    job->nchunks = 0;
+    job->cur = 0;
+    job->done = done;
+    job->on_wire = on_wire;
+    job->user = user;
+
+    job->chunks[job->nchunks++] = (struct tlv_seg){ job->hdr, TLV_HDR_BYTES };
+    for (size_t i = 0; i < nsegs; i++) {
+        if (segs[i].len == 0 || segs[i].data == NULL) {
+            continue;
+        }
+        job->chunks[job->nchunks++] = segs[i];
+        total += segs[i].len;
+    }
+    job->chunks[job->nchunks++] = (struct tlv_seg){ job->ftr, TLV_FTR_BYTES };
+
+    sys_put_le32(FRAME_HDR, &job->hdr[0]);
+    job->hdr[4] = type;
+    sys_put_le16((uint16_t)total, &job->hdr[5]);
+    sys_put_le32(FRAME_FTR, job->ftr);
+
+    atomic_add(&link_bytes_sent, (atomic_val_t)(TLV_HDR_BYTES + total + TLV_FTR_BYTES));
+    return total;
+}
+#endif /* CONFIG_PDM_FRAMING_COBS */
+
+/* The job's last byte left the UART */
+static void job_finish(struct tlv_job *job)
+{
+    if (job->done) {
+        job->done(job->user);
+    }
+    if (job->on_wire) {
+        job->on_wire(job->user);
+    }
+}
+
+static void job_send_poll(struct tlv_job *job)
+{
+    for (uint8_t c = 0; c < job->nchunks; c++) {
+        const uint8_t *p = job->chunks[c].data;
+
+        for (uint16_t i = 0; i < job->chunks[c].len; i++) {
+            uart_poll_out(uart_dev, p[i]);
+        }
+    }
+    job_finish(job);
+}
+
+#if defined(CONFIG_PDM_UART_TX_ASYNC)
+/* ---------- async backend ---------- */
+
+/* Retire the in-flight job and return the next queued one (or NULL) */
+static struct tlv_job *job_retire(struct tlv_job *job)
+{
+    struct tlv_job *next = NULL;
+
+    job_finish(job);
+
+    k_spinlock_key_t key = k_spin_lock(&job_lock);
+    job_head = (job_head + 1) % TLV_LINK_JOBS;
+    job_pending--;
+    if (job_pending) {
+        next = &jobs[job_head];
+    }
+    k_spin_unlock(&job_lock, key);
+
+    k_sem_give(&job_free);
+    return next;
+}
+
+/* Start the current chunk of job; on a driver error drop the job and move on */
+static void job_kick(struct tlv_job *job)
+{
+    while (job) {
+        const struct tlv_seg *c = &job->chunks[job->cur];
+
+        if (uart_tx(uart_dev, c->data, c->len, SYS_FOREVER_US) == 0) {
+            return;
+        }
+        job = job_retire(job);
+    }
+}
+
+static void uart_async_cb(const struct device *dev, struct uart_event *evt, void *user_data)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(user_data);
+
+    switch (evt->type) {
+    case UART_TX_DONE: {
+        struct tlv_job *job = &jobs[job_head];
+
+        if (++job->cur < job->nchunks) {
+            job_kick(job);
+        } else {
+            job_kick(job_retire(job));
+        }
+        break;
+    }
+    case UART_TX_ABORTED:
+        job_kick(job_retire(&jobs[job_head]));
+        break;
+#if defined(CONFIG_PDM_TLV_RX)
+    /* RX: the ISR only moves bytes into rx_ring, the RX thread parses them */
+    case UART_RX_RDY:
+        ring_buf_put(&rx_ring, evt->data.rx.buf + evt->data.rx.offset, evt->data.rx.len);
+        k_sem_give(&rx_ready);
+        break;
+    case UART_RX_BUF_REQUEST:
+        uart_rx_buf_rsp(uart_dev, rx_dma[rx_dma_next], RX_DMA_BYTES);
+        rx_dma_next ^= 1;
+        break;
+    case UART_RX_DISABLED:
+        if (rx_hold) {
+            k_sem_give(&rx_stopped);
+            break;
+        }
+        /* Line errors stop RX: start over */
+        rx_dma_next = 1;
+        uart_rx_enable(uart_dev, rx_dma[0], RX_DMA_BYTES, RX_TIMEOUT_US);
+        break;
+#endif
+    default:
+        break;
+    }
+}
+
+/* Wait for a free slot; the tail slot is only touched by producers */
+static struct tlv_job *job_claim(void)
+{
+    k_sem_take(&job_free, K_FOREVER);
+    return &jobs[job_tail];
+}
+
+static void job_commit(struct tlv_job *job)
+{
+    job_tail = (job_tail + 1) % TLV_LINK_JOBS;
+
+    k_spinlock_key_t key = k_spin_lock(&job_lock);
+    bool start = (job_pending == 0);
+    job_pending++;
+    k_spin_unlock(&job_lock, key);
+
+    if (start) {
+        job_kick(job);
+    }
+}
+#endif /* CONFIG_PDM_UART_TX_ASYNC */
+
+/* ---------- public API ---------- */
+int tlv_link_init(const struct device *uart)
+{
+    uart_dev = uart;
+
+#if defined(CONFIG_PDM_UART_TX_ASYNC)
+    int ret = uart_callback_set(uart_dev, uart_async_cb, NULL);
+    if (ret == 0) {
+        link_mode = TLV_LINK_MODE_ASYNC;
+        return 0;
+    }
+    printk("uart async not available (%d), using poll TX\n", ret);
+#endif
+    link_mode = TLV_LINK_MODE_POLL;
+    return 0;
+}
+
+int tlv_link_set_mode(enum tlv_link_mode mode)
+{
+#if !defined(CONFIG_PDM_UART_TX_ASYNC)
+    if (mode == TLV_LINK_MODE_ASYNC) {
+        return -ENOTSUP;
+    }
+#endif
+    k_mutex_lock(&link_mutex, K_FOREVER);
+    tlv_link_flush();
+    link_mode = mode;
+    k_mutex_unlock(&link_mutex);
+    return 0;
+}
+
+enum tlv_link_mode tlv_link_get_mode(void)
+{
+    return link_mode;
+}
+
+int tlv_link_send_segs(uint8_t type, const struct tlv_seg *segs, size_t nsegs,
+                       tlv_link_done_cb done, void *user)
+{
+    return tlv_link_send_segs_wire(type, segs, nsegs, done, NULL, user);
+}
+
+int tlv_link_send_segs_wire(uint8_t type, const struct tlv_seg *segs, size_t nsegs,
+                            tlv_link_done_cb done, tlv_link_done_cb on_wire, void *user)
+{
+    int err = 0;
+
+    if (nsegs > TLV_LINK_MAX_SEGS) {
+        err = -EINVAL;
+    } else if (segs_total(segs, nsegs) > TLV_LINK_VALUE_MAX) {
+        err = -EMSGSIZE;
+    }
+    if (err) {
+        if (done) {
+            done(user);
+        }
+        if (on_wire) {
+            on_wire(user);
+        }
+        return err;
+    }
+
+    k_mutex_lock(&link_mutex, K_FOREVER);
+#if defined(CONFIG_PDM_UART_TX_ASYNC)
+    if (link_mode == TLV_LINK_MODE_ASYNC) {
+        struct tlv_job *job = job_claim();
+
+        job_fill(job, type, segs, nsegs, done, on_wire, user);
+        job_commit(job);
+        k_mutex_unlock(&link_mutex);
+        return 0;
+    }
+#endif
+    job_fill(&poll_job, type, segs, nsegs, done, on_wire, user);
+    job_send_poll(&poll_job);
+    k_mutex_unlock(&link_mutex);
+    return 0;
+}
+
+int tlv_link_send(uint8_t type, const void *val, uint16_t len)
+{
+    if (len > TLV_LINK_INLINE_MAX) {
+        return -EMSGSIZE;
+    }
+
+    k_mutex_lock(&link_mutex, K_FOREVER);
+#if defined(CONFIG_PDM_UART_TX_ASYNC)
+    if (link_mode == TLV_LINK_MODE_ASYNC) {
+        /* The copy has to live until the frame is on the wire: keep it in the slot */
+        struct tlv_job *job = job_claim();
+        struct tlv_seg seg = { job->inline_buf, len };
+
+        memcpy(job->inline_buf, val, len);
+        job_fill(job, type, &seg, 1, NULL, NULL, NULL);
+        job_commit(job);
+        k_mutex_unlock(&link_mutex);
+        return 0;
+    }
+#endif
+    struct tlv_seg seg = { val, len };
+
+    job_fill(&poll_job, type, &seg, 1, NULL, NULL, NULL);
+    job_send_poll(&poll_job);
+    k_mutex_unlock(&link_mutex);
+    return 0;
+}
+
+int tlv_link_send_u32(uint8_t type, uint32_t v)
+{
+    uint8_t b[4];
+
+    sys_put_le32(v, b);
+    return tlv_link_send(type, b, sizeof(b));
+}
+
+void tlv_link_flush(void)
+{
+#if defined(CONFIG_PDM_UART_TX_ASYNC)
+    for (int i = 0; i < TLV_LINK_JOBS; i++) {
+        k_sem_take(&job_free, K_FOREVER);
+    }
+    for (int i = 0; i < TLV_LINK_JOBS; i++) {
+        k_sem_give(&job_free);
+    }
+#endif
+}
+
+void tlv_link_wait_slot(void)
+{
+#if defined(CONFIG_PDM_UART_TX_ASYNC)
+    k_sem_take(&job_free, K_FOREVER);
+    k_sem_give(&job_free);
+#endif
+}
+
+uint32_t tlv_link_bytes_sent(void)
+{
+    return (uint32_t)atomic_get(&link_bytes_sent);
+}
+
+#if defined(CONFIG_UART_USE_RUNTIME_CONFIGURE)
+int tlv_link_set_baud(uint32_t baud, k_timeout_t quiet)
+{
+    struct uart_config cfg;
+    int ret;
+
+    k_mutex_lock(&link_mutex, K_FOREVER);
+    tlv_link_flush();
+
+    ret = uart_config_get(uart_dev, &cfg);
+    if (ret || cfg.baudrate == baud) {
+        k_mutex_unlock(&link_mutex);
+        return ret;
+    }
+    /* TX done means out of the buffer, the last bytes may still be shifting */
+    k_busy_wait(2 * 10 * USEC_PER_SEC / cfg.baudrate + 1);
+
+#if defined(CONFIG_PDM_TLV_RX) && defined(CONFIG_PDM_UART_TX_ASYNC)
+    /* uart_configure() is refused while async RX runs */
+    if (rx_async) {
+        rx_hold = true;
+        if (uart_rx_disable(uart_dev) == 0) {
+            k_sem_take(&rx_stopped, K_MSEC(100));
+        }
+    }
+#endif
+
+    cfg.baudrate = baud;
+    ret = uart_configure(uart_dev, &cfg);
+
+#if defined(CONFIG_PDM_TLV_RX) && defined(CONFIG_PDM_UART_TX_ASYNC)
+    if (rx_async) {
+        rx_hold = false;
+        rx_dma_next = 1;
+        uart_rx_enable(uart_dev, rx_dma[0], RX_DMA_BYTES, RX_TIMEOUT_US);
+    }
+#endif
+    /* a host frame cut by the switch fails its footer / CRC and is dropped */
+    k_sleep(quiet);
+    k_mutex_unlock(&link_mutex);
+    return ret;
+}
+
+uint32_t tlv_link_get_baud(void)
+{
+    struct uart_config cfg;
+
+    return uart_config_get(uart_dev, &cfg) == 0 ? cfg.baudrate : 0;
+}
+#else
+int tlv_link_set_baud(uint32_t baud, k_timeout_t quiet)
+{
+    ARG_UNUSED(baud);
+    ARG_UNUSED(quiet);
+    return -ENOTSUP;
+}
+
+uint32_t tlv_link_get_baud(void)
+{
+    return 0;
+}
+#endif /* CONFIG_UART_USE_RUNTIME_CONFIGURE */
+
+#if defined(CONFIG_PDM_TLV_RX)
+/* ---------- host -> device ---------- */
+#if defined(CONFIG_PDM_FRAMING_COBS)
+/* In place: the decoded frame is never longer than the encoded one */
+static size_t cobs_decode(uint8_t *buf, size_t n)
+{
+    size_t in = 0, out = 0;
+
+    while (in < n) {
+        uint8_t code = buf[in++];
+
+        if (code == 0 || in + code - 1 > n) {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            buf[out++] = buf[in++];
+        }
+        if (code != 0xFF && in < n) {
+            buf[out++] = 0x00;
+        }
+    }
+    return out;
+}
+
+/* Bytes up to a 0x00 are one frame; anything malformed is simply dropped */
+static void rx_feed(uint8_t b)
+{
+    if (b != 0x00) {
+        if (rx.pos < sizeof(rx.buf)) {
+            rx.buf[rx.pos++] = b;
+        } else {
+            rx.overflow = true;
+        }
+        return;
+    }
+
+    size_t n = rx.overflow ? 0 : cobs_decode(rx.buf, rx.pos);
+
+    rx.pos = 0;
+    rx.overflow = false;
+    if (n < COBS_TL_BYTES + COBS_CRC_BYTES) {
+        return;
+    }
+
+    uint16_t len = sys_get_le16(&rx.buf[1]);
+
+    if (len != n - COBS_TL_BYTES - COBS_CRC_BYTES ||
+        crc32_ieee(rx.buf, n - COBS_CRC_BYTES) != sys_get_le32(&rx.buf[n - COBS_CRC_BYTES])) {
+        return;
+    }
+    if (rx_cb) {
+        rx_cb(rx.buf[0], &rx.buf[COBS_TL_BYTES], len);
+    }
+}
+#else
+static void rx_feed(uint8_t b)
+{
+    switch (rx.state) {
+    case RX_HUNT:
+        rx.win = (rx.win >> 8) | ((uint32_t)b << 24);
+        if (rx.win == FRAME_HDR) {
+            rx.state = RX_TYPE;
+        }
+        return;
+    case RX_TYPE:
+        rx.type = b;
+        rx.state = RX_LEN0;
+        return;
+    case RX_LEN0:
+        rx.len = b;
+        rx.state = RX_LEN1;
+        return;
+    case RX_LEN1:
+        rx.len |= (uint16_t)b << 8;
+        rx.pos = 0;
+        rx.state = (rx.len > TLV_LINK_RX_MAX) ? RX_HUNT : (rx.len ? RX_VAL : RX_FTR);
+        rx.win = 0;
+        return;
+    case RX_VAL:
+        rx.val[rx.pos++] = b;
+        if (rx.pos == rx.len) {
+            rx.state = RX_FTR;
+        }
+        return;
+    case RX_FTR:
+        rx.win = (rx.win >> 8) | ((uint32_t)b << 24);
+        if (++rx.pos < rx.len + 4) {
+            return;
+        }
+        if (rx.win == FRAME_FTR && rx_cb) {
+            rx_cb(rx.type, rx.val, rx.len);
+        }
+        rx.win = 0;
+        rx.state = RX_HUNT;
+        return;
+    }
+}
+#endif /* CONFIG_PDM_FRAMING_COBS */
+
+static void rx_thread(void *p1, void *p2, void *p3)
+{
+    ARG_UNUSED(p1); ARG_UNUSED(p2); ARG_UNUSED(p3);
+
+    while (1) {
+#if defined(CONFIG_PDM_UART_TX_ASYNC)
+        if (rx_async) {
+            uint8_t buf[32];
+            uint32_t n;
+
+            k_sem_take(&rx_ready, K_FOREVER);
+            while ((n = ring_buf_get(&rx_ring, buf, sizeof(buf))) > 0) {
+                for (uint32_t i = 0; i < n; i++) {
+                    rx_feed(buf[i]);
+                }
+            }
+            continue;
+        }
+#endif
+        unsigned char c;
+
+        if (uart_poll_in(uart_dev, &c) == 0) {
+            rx_feed(c);
+        } else {
+            k_sleep(K_MSEC(RX_POLL_MS));
+        }
+    }
+}
+
+int tlv_link_rx_start(tlv_link_rx_cb cb)
+{
+    rx_cb = cb;
+    memset(&rx, 0, sizeof(rx));
+
+#if defined(CONFIG_PDM_UART_TX_ASYNC)
+    if (link_mode == TLV_LINK_MODE_ASYNC) {
+        rx_dma_next = 1;
+        rx_async = (uart_rx_enable(uart_dev, rx_dma[0], RX_DMA_BYTES, RX_TIMEOUT_US) == 0);
+    }
+#endif
+
+    k_thread_create(&rx_thread_data, rx_stack, RX_STACK_SIZE,
+                    rx_thread, NULL, NULL, NULL, RX_PRIO, 0, K_NO_WAIT);
+    return 0;
+}
+#else
+int tlv_link_rx_start(tlv_link_rx_cb cb)
+{
+    ARG_UNUSED(cb);
+    return -ENOTSUP;
+}
+#endif /* CONFIG_PDM_TLV_RX */
@@ -0,0 +1,155 @@
+#ifndef TLV_LINK_H_
+#define TLV_LINK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Framed TLV writer for the PDM stream, one of (CONFIG_PDM_FRAMING_*):
+ *   magic: FRAME_HDR(4 LE) + T(1) + L(2 LE) + V(L) + FRAME_FTR(4 LE)
+ *   cobs : COBS(T(1) + L(2 LE) + V(L) + CRC32(4 LE)) + 0x00
+ *          CRC-32/IEEE (zlib.crc32) over T..V. 0x00 never occurs inside
+ *          a frame, so the receiver resyncs at the next 0x00. The frame
+ *          is encoded into the job, so values are copied, not DMA'd.
+ * Host -> device frames use the same framing.
+ *
+ * Two backends:
+ *   - poll : every byte goes through uart_poll_out() (works everywhere)
+ *   - async: uart_tx() on EasyDMA/async capable UARTs; the value is handed
+ *            to the peripheral without a copy and released from the
+ *            UART_TX_DONE callback.
+ */
+
+#define FRAME_HDR 0xAA55AA55u
+#define FRAME_FTR 0xA5A5A5A5u
+
+/* ---------- TLV Types ---------- */
+#define TLV_T_PCM_BLOCK     0x01   /* raw PCM bytes */
+#define TLV_T_TIMESTAMP_MS  0x02   /* uint32 little-endian */
+#define TLV_T_PCM_BATCH     0x03   /* pcm_batch_hdr + N raw PCM blocks */
+#define TLV_T_ADPCM_BATCH   0x04   /* pcm_batch_hdr + N IMA-ADPCM blocks */
+#define TLV_T_LOSSLESS_BATCH 0x05  /* pcm_batch_hdr + N fixed-LPC/Rice blocks */
+#define TLV_T_SILENCE       0x06   /* pcm_batch_hdr of N blocks the VAD held back
+                                      + noise_floor_rms(2 LE), no samples */
+#define TLV_T_SPECTRUM_BATCH 0x07  /* pcm_batch_hdr + N spectrum frames, see spectrum.h */
+#define TLV_T_MFCC_BATCH    0x08   /* pcm_batch_hdr + N MFCC blocks, see mfcc.h */
+#define TLV_T_PCM_HALF_BATCH 0x09  /* pcm_batch_hdr + N raw PCM blocks at half the
+                                      stream rate, see decim.h */
+#define TLV_T_STATS         0x10   /* pipeline health, see stats.h */
+#define TLV_T_LAT_HIST      0x11   /* one latency histogram, see latency.h */
+#define TLV_T_STREAM_CFG_ACK 0x12  /* status(4, 0 / -errno) + applied config:
+                                      rate_hz(4) block_ms(2) channels(1)
+                                      width_bits(1) block_bytes(2) pool_blocks(2) */
+#define TLV_T_LINK_RATE_ACK 0x13   /* status(4) baud(4) boot_baud(4), see link_rate.h */
+#define TLV_T_LINK_TEST     0x14   /* link rate verify burst, see link_rate.h */
+#define TLV_T_TRIGGER_EVENT 0x15   /* sources(1, bit per enum trigger_src) reserved(1)
+                                      preroll_blocks(2) first_sample(8) of the
+                                      triggering block, ahead of its clip; see trigger.h */
+#define TLV_T_SYNC          0x7F   /* ASCII "SYNC" */
+
+/* ---------- Host -> device TLV Types (same framing) ---------- */
+#define TLV_T_LAT_DUMP      0x40   /* flags(1): bit0 = reset after dump */
+#define TLV_T_STREAM_CFG    0x41   /* rate_hz(4) block_ms(2) channels(1) width_bits(1),
+                                      0 = keep; empty = query. Answered by
+                                      TLV_T_STREAM_CFG_ACK */
+#define TLV_T_LINK_RATE     0x42   /* baud(4), 0 = keepalive */
+#define TLV_T_LINK_CONFIRM  0x43   /* ok(1), sent at the new rate */
+#define TLV_T_NS_CTRL       0x44   /* enable(1): noise suppression on / off, see ns.h */
+#define TLV_T_TRIGGER_CTRL  0x45   /* fire(1): 1 = trigger now, 0 = re-arm, see trigger.h */
+
+#define TLV_LINK_JOBS        2    /* double buffer: one in flight, one staged */
+#define TLV_LINK_MAX_SEGS    10   /* gather segments per frame value */
+#define TLV_LINK_INLINE_MAX  64   /* values copied by tlv_link_send() */
+#define TLV_LINK_RX_MAX      64   /* longest host -> device value */
+
+#if defined(CONFIG_PDM_FRAMING_COBS)
+#define TLV_LINK_VALUE_MAX   CONFIG_PDM_FRAMING_COBS_MAX_VALUE
+#else
+#define TLV_LINK_VALUE_MAX   UINT16_MAX
+#endif
+
+enum tlv_link_mode {
+    TLV_LINK_MODE_POLL = 0,
+    TLV_LINK_MODE_ASYNC,
+};
+
+/* One piece of a frame value; the frame value is the concatenation */
+struct tlv_seg {
+    const void *data;
+    uint16_t    len;
+};
+
+/*
+ * Called once the segments of a frame are no longer needed.
+ * In async mode this runs in the UART ISR: keep it short (k_mem_slab_free).
+ */
+typedef void (*tlv_link_done_cb)(void *user);
+
+/* A complete host -> device frame; runs in the link RX thread */
+typedef void (*tlv_link_rx_cb)(uint8_t type, const uint8_t *val, uint16_t len);
+
+int  tlv_link_init(const struct device *uart);
+int  tlv_link_set_mode(enum tlv_link_mode mode);
+enum tlv_link_mode tlv_link_get_mode(void);
+
+/* Copies val (len <= TLV_LINK_INLINE_MAX), caller may reuse it at once */
+int  tlv_link_send(uint8_t type, const void *val, uint16_t len);
+int  tlv_link_send_u32(uint8_t type, uint32_t v);
+
+/*
+ * Zero-copy send of a frame whose value is segs[0..nsegs-1]
+ * (at most TLV_LINK_VALUE_MAX bytes in total).
+ * done(user) is always called exactly once, also on error.
+ */
+int  tlv_link_send_segs(uint8_t type, const struct tlv_seg *segs, size_t nsegs,
+                        tlv_link_done_cb done, void *user);
+
+/*
+ * Same, plus on_wire(user) once the frame has left the UART, also exactly
+ * once. With magic framing it runs right after done(); under COBS done()
+ * comes as soon as the value is copied into the job, on_wire() later.
+ */
+int  tlv_link_send_segs_wire(uint8_t type, const struct tlv_seg *segs, size_t nsegs,
+                             tlv_link_done_cb done, tlv_link_done_cb on_wire, void *user);
+
+/* Block until every queued frame has left the UART */
+void tlv_link_flush(void);
+
+/*
+ * Block until a job is free, so the next send from this thread does not
+ * wait for the UART (there is no queue in poll mode: returns at once)
+ */
+void tlv_link_wait_slot(void);
+
+/* Framed bytes handed to the UART since boot (wraps) */
+uint32_t tlv_link_bytes_sent(void);
+
+/*
+ * Switch the UART baud rate between two frames: waits until everything
+ * queued is on the wire, reconfigures (restarting async RX around it) and
+ * keeps the line quiet for `quiet` so the peer can follow. Returns
+ * -ENOTSUP without CONFIG_UART_USE_RUNTIME_CONFIGURE.
+ */
+int  tlv_link_set_baud(uint32_t baud, k_timeout_t quiet);
+
+/* Current UART baud rate, 0 if unknown */
+uint32_t tlv_link_get_baud(void);
+
+/*
+ * Start parsing host -> device frames off the same UART. Uses async RX
+ * when the link came up in async mode, uart_poll_in() otherwise.
+ * Returns -ENOTSUP without CONFIG_PDM_TLV_RX.
+ */
+int  tlv_link_rx_start(tlv_link_rx_cb cb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TLV_LINK_H_
@@ -0,0 +1,140 @@
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/sys/byteorder.h>
+#include <math.h>
+#include <stdlib.h>
+#include "tlv_link.h"
+#include "trigger.h"
+
+#if DT_NODE_EXISTS(DT_ALIAS(appsw0))
+#define TRIGGER_SW  DT_ALIAS(appsw0)
+#elif DT_NODE_EXISTS(DT_ALIAS(sw0))
+#define TRIGGER_SW  DT_ALIAS(sw0)
+#endif
+
+static atomic_t fire_srcs;      /* BIT(enum trigger_src) not seen by the TX thread yet */
+static atomic_t arm_req;
+
+/* TX thread; boots armed */
+static bool live;
+static uint64_t live_until;     /* first sample past the post-trigger window */
+static uint64_t last_sample;
+static uint8_t  clip_srcs;
+
+/* Peak at or above this triggers; 0 = no level trigger */
+static int32_t level_thr;
+
+#if defined(TRIGGER_SW) && defined(CONFIG_GPIO)
+static const struct gpio_dt_spec sw = GPIO_DT_SPEC_GET(TRIGGER_SW, gpios);
+static struct gpio_callback sw_cb;
+
+static void sw_pressed(const struct device *dev, struct gpio_callback *cb, uint32_t pins)
+{
+    trigger_fire(TRIGGER_SRC_GPIO);
+}
+
+static int sw_init(void)
+{
+    int ret;
+
+    if (!gpio_is_ready_dt(&sw)) {
+        return -ENODEV;
+    }
+    ret = gpio_pin_configure_dt(&sw, GPIO_INPUT);
+    if (ret == 0) {
+        ret = gpio_pin_interrupt_configure_dt(&sw, GPIO_INT_EDGE_TO_ACTIVE);
+    }
+    if (ret == 0) {
+        gpio_init_callback(&sw_cb, sw_pressed, BIT(sw.pin));
+        ret = gpio_add_callback(sw.port, &sw_cb);
+    }
+    return ret;
+}
+#else
+static int sw_init(void)
+{
+    return -ENOTSUP;
+}
+#endif
+
+int trigger_init(void)
+{
+    if (CONFIG_PDM_TRIGGER_LEVEL_DBFS < 0) {
+        level_thr = lroundf(32767.0f * powf(10.0f, CONFIG_PDM_TRIGGER_LEVEL_DBFS / 20.0f));
+    }
+    return sw_init();
+}
+
+void trigger_fire(enum trigger_src src)
+{
+    atomic_or(&fire_srcs, BIT(src));
+}
+
+void trigger_arm(void)
+{
+    atomic_set(&arm_req, 1);
+}
+
+bool trigger_level(const int16_t *pcm, uint32_t frames, uint8_t channels)
+{
+    if (level_thr == 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < frames * channels; i++) {
+        if (abs(pcm[i]) >= level_thr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+enum trigger_gate trigger_gate(const struct audio_item *it, uint32_t rate_hz)
+{
+    uint8_t srcs = (uint8_t)atomic_clear(&fire_srcs);
+
+    if (it->trigger) {
+        srcs |= BIT(TRIGGER_SRC_LEVEL);
+    }
+    /* re-armed by the host, or a new stream (capture restarted) */
+    if (atomic_clear(&arm_req) || it->first_sample < last_sample) {
+        live = false;
+    }
+    last_sample = it->first_sample;
+
+    if (srcs != 0) {
+        bool was_live = live;
+
+        /* every trigger inside the window extends it */
+        live = true;
+        live_until = it->first_sample + (uint64_t)CONFIG_PDM_TRIGGER_POST_MS * rate_hz / 1000u;
+        if (!was_live) {
+            clip_srcs = srcs;
+            return TRIGGER_FIRED;
+        }
+        return TRIGGER_LIVE;
+    }
+    if (live && CONFIG_PDM_TRIGGER_POST_MS != 0 && it->first_sample >= live_until) {
+        live = false;
+    }
+    return live ? TRIGGER_LIVE : TRIGGER_HOLD;
+}
+
+bool trigger_streaming(const struct audio_item *it)
+{
+    if (!live || atomic_get(&arm_req) || it->first_sample < last_sample) {
+        return false;
+    }
+    return CONFIG_PDM_TRIGGER_POST_MS == 0 || it->first_sample < live_until;
+}
+
+void trigger_report(uint64_t first_sample, uint16_t preroll_blocks)
+{
+    uint8_t v[12];
+
+    v[0] = clip_srcs;
+    v[1] = 0;
+    sys_put_le16(preroll_blocks, &v[2]);
+    sys_put_le64(first_sample, &v[4]);
+    tlv_link_send(TLV_T_TRIGGER_EVENT, v, sizeof(v));
+}
@@ -0,0 +1,94 @@
+#ifndef TRIGGER_H_
+#define TRIGGER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fanout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Triggered capture (CONFIG_PDM_TRIGGER). Capture runs all the time, but
+ * while armed the TX thread only keeps the newest
+ * CONFIG_PDM_TRIGGER_PREROLL_MS of blocks (held slab blocks, no copies)
+ * and sends nothing. A trigger sends TLV_T_TRIGGER_EVENT, then the whole
+ * pre-roll back to back (the TX thread batches it at whatever the link
+ * takes), then live audio: for CONFIG_PDM_TRIGGER_POST_MS after the last
+ * trigger, or until the host re-arms when that is 0.
+ *
+ * Trigger sources:
+ *   level  a block peaking at CONFIG_PDM_TRIGGER_LEVEL_DBFS or above,
+ *          measured ahead of the AGC (audio_item.trigger)
+ *   gpio   the appsw0 button (sw0 if the board has no appsw0)
+ *   host   TLV_T_TRIGGER_CTRL
+ *
+ * Blocks dropped while armed never reach the host, so a clip starts with
+ * a jump in first_sample; TLV_T_TRIGGER_EVENT tells the host it is one.
+ */
+
+enum trigger_src {
+    TRIGGER_SRC_LEVEL = 0,
+    TRIGGER_SRC_GPIO,
+    TRIGGER_SRC_HOST,
+};
+
+enum trigger_gate {
+    TRIGGER_HOLD,       /* armed: keep as pre-roll */
+    TRIGGER_FIRED,      /* first block of a clip: send the pre-roll, then this */
+    TRIGGER_LIVE,       /* streaming (the VAD may still gate it) */
+};
+
+#if defined(CONFIG_PDM_TRIGGER)
+/* Pre-roll of a stream with block_ms blocks */
+#define TRIGGER_PREROLL_BLOCKS(block_ms)  DIV_ROUND_UP(CONFIG_PDM_TRIGGER_PREROLL_MS, (block_ms))
+
+/* Longest pre-roll any stream config can get (it has to fit the pool) */
+#define TRIGGER_PREROLL_MAX     CONFIG_PDM_AUDIO_POOL_MAX_BLOCKS
+
+/* GPIO trigger and level threshold; capture boots armed */
+int  trigger_init(void);
+
+/* Any context, ISRs included */
+void trigger_fire(enum trigger_src src);
+void trigger_arm(void);
+
+/* Capture thread: block reaches the trigger level */
+bool trigger_level(const int16_t *pcm, uint32_t frames, uint8_t channels);
+
+/* TX thread, once per block in capture order */
+enum trigger_gate trigger_gate(const struct audio_item *it, uint32_t rate_hz);
+
+/* TX thread: gate will pass `it` as LIVE (no side effects, for batching) */
+bool trigger_streaming(const struct audio_item *it);
+
+/* TX thread, on TRIGGER_FIRED: TLV_T_TRIGGER_EVENT, the clip starts at first_sample */
+void trigger_report(uint64_t first_sample, uint16_t preroll_blocks);
+#else
+#define TRIGGER_PREROLL_BLOCKS(block_ms)  0
+#define TRIGGER_PREROLL_MAX     0
+
+static inline int  trigger_init(void) { return 0; }
+static inline void trigger_fire(enum trigger_src src) {}
+static inline void trigger_arm(void) {}
+static inline bool trigger_level(const int16_t *pcm, uint32_t frames, uint8_t channels)
+{
+    return false;
+}
+static inline enum trigger_gate trigger_gate(const struct audio_item *it, uint32_t rate_hz)
+{
+    return TRIGGER_LIVE;
+}
+static inline bool trigger_streaming(const struct audio_item *it)
+{
+    return true;
+}
+static inline void trigger_report(uint64_t first_sample, uint16_t preroll_blocks) {}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRIGGER_H_
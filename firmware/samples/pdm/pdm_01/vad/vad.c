@@ -0,0 +1,129 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include "vad.h"
+
+/* 10^(1/10) in Q16: one dB of power */
+#define DB_STEP_Q16     82504u
+
+/* Floor never goes below this (mean square), so the ratios stay meaningful */
+#define FLOOR_MIN       4u
+
+/* Noise floor, mean square in int16^2 units. Written by the capture thread. */
+static atomic_t floor_ms;
+static uint16_t hang;
+static uint32_t thr_q8;        /* speech: energy > floor * thr */
+static uint32_t thr_soft_q8;   /* noisy speech: energy > floor * thr_soft and high ZCR */
+static uint32_t min_energy;
+
+static uint32_t db_to_q8(int db)
+{
+    uint32_t r = 256u << 16;
+
+    while (db-- > 0) {
+        r = (uint32_t)(((uint64_t)r * DB_STEP_Q16) >> 16);
+    }
+    return r >> 16;
+}
+
+static inline uint32_t mul_q8(uint32_t v, uint32_t q8)
+{
+    uint64_t r = ((uint64_t)v * q8) >> 8;
+
+    return r > UINT32_MAX ? UINT32_MAX : (uint32_t)r;
+}
+
+static uint16_t isqrt32(uint32_t v)
+{
+    uint32_t r = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)r;
+}
+
+void vad_reset(void)
+{
+    thr_q8 = db_to_q8(CONFIG_PDM_VAD_THRESHOLD_DB);
+    thr_soft_q8 = MAX(db_to_q8(CONFIG_PDM_VAD_THRESHOLD_DB - 3), 256u + 64u);
+    min_energy = (uint32_t)CONFIG_PDM_VAD_MIN_RMS * CONFIG_PDM_VAD_MIN_RMS;
+
+    atomic_set(&floor_ms, 0);
+    hang = CONFIG_PDM_VAD_HANGOVER_BLOCKS;
+}
+
+bool vad_block(const int16_t *pcm, uint32_t frames, uint8_t channels, uint32_t rate_hz)
+{
+    if (frames == 0) {
+        return hang > 0;
+    }
+
+    int64_t sum = 0;
+    uint64_t sumsq = 0;
+
+    for (uint32_t i = 0; i < frames; i++) {
+        int32_t x = pcm[i * channels];
+
+        sum += x;
+        sumsq += (uint64_t)(x * x);
+    }
+
+    const int32_t mean = (int32_t)(sum / (int64_t)frames);
+    const uint32_t energy = (uint32_t)((sumsq - (uint64_t)((sum * sum) / (int64_t)frames)) / frames);
+
+    uint32_t zc = 0;
+    bool neg = pcm[0] < mean;
+
+    for (uint32_t i = 1; i < frames; i++) {
+        bool n = pcm[i * channels] < mean;
+
+        zc += n != neg;
+        neg = n;
+    }
+
+    uint32_t floor = (uint32_t)atomic_get(&floor_ms);
+
+    if (floor == 0) {
+        /* first block after a reset: best guess, corrected downwards below */
+        floor = MAX(energy, FLOOR_MIN);
+    }
+
+    const bool noisy = (uint64_t)zc * rate_hz >= (uint64_t)CONFIG_PDM_VAD_ZCR_HZ * frames;
+    const bool speech = energy >= min_energy &&
+                        (energy > mul_q8(floor, thr_q8) ||
+                         (noisy && energy > mul_q8(floor, thr_soft_q8)));
+
+    if (energy < floor) {
+        floor -= (floor - energy) >> 2;
+    } else if (!speech) {
+        floor += (energy - floor) >> 4;
+    } else {
+        floor += (floor >> 7) + 1;
+    }
+    atomic_set(&floor_ms, (atomic_val_t)MAX(floor, FLOOR_MIN));
+
+    if (speech) {
+        hang = CONFIG_PDM_VAD_HANGOVER_BLOCKS;
+        return true;
+    }
+    if (hang > 0) {
+        hang--;
+        return true;
+    }
+    return false;
+}
+
+uint16_t vad_noise_floor_rms(void)
+{
+    return isqrt32((uint32_t)atomic_get(&floor_ms));
+}
@@ -0,0 +1,57 @@
+#ifndef VAD_H_
+#define VAD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed-point voice activity detector, one decision per audio_slab block
+ * (CONFIG_PDM_VAD). Runs in the capture thread on channel 0 of the raw
+ * int16 PCM, before the codec touches it.
+ *
+ * Per block: mean-removed energy and zero crossings per second. A block
+ * is speech when its energy is CONFIG_PDM_VAD_THRESHOLD_DB above the
+ * tracked noise floor, or half that (3 dB less) with a zero-crossing rate
+ * of at least CONFIG_PDM_VAD_ZCR_HZ (unvoiced consonants are quiet but
+ * noisy). Speech is held for CONFIG_PDM_VAD_HANGOVER_BLOCKS after the
+ * last speech block so word endings and short pauses still go out.
+ *
+ * The noise floor falls quickly to quieter blocks and rises slowly: faster
+ * in silence, very slowly under speech, so a louder fan that starts mid
+ * sentence is eventually treated as background.
+ */
+
+#if defined(CONFIG_PDM_VAD)
+#define VAD_PREROLL_BLOCKS      CONFIG_PDM_VAD_PREROLL_BLOCKS
+#define VAD_SILENCE_MAX_BLOCKS  CONFIG_PDM_VAD_SILENCE_MAX_BLOCKS
+
+/*
+ * Call before the first block of a stream (also after a restart). The
+ * first CONFIG_PDM_VAD_HANGOVER_BLOCKS count as speech while the floor settles.
+ */
+void     vad_reset(void);
+
+/* frames samples per channel, interleaved when channels > 1 */
+bool     vad_block(const int16_t *pcm, uint32_t frames, uint8_t channels, uint32_t rate_hz);
+
+/* Current noise floor as an RMS in int16 units; any thread */
+uint16_t vad_noise_floor_rms(void);
+#else
+#define VAD_PREROLL_BLOCKS      0
+#define VAD_SILENCE_MAX_BLOCKS  1
+
+static inline void vad_reset(void) {}
+static inline bool vad_block(const int16_t *pcm, uint32_t frames, uint8_t channels,
+                             uint32_t rate_hz) { return true; }
+static inline uint16_t vad_noise_floor_rms(void) { return 0; }
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VAD_H_
@@ -0,0 +1,162 @@
+"""
+Host parser benchmark for the two pdm_01 framings (CONFIG_PDM_FRAMING_*).
+
+Builds a stream of realistic PCM batch frames (counter pattern, like
+CONFIG_PDM_TEST_PATTERN_COUNTER), optionally corrupts it, and pushes it
+through SerialTLVSource's reader loop via an in-memory serial port:
+
+  python pdm_framing_bench.py --seconds 30 --blocks 4 --ber 1e-5
+
+Per framing it reports parser throughput (MB/s and x real time at the
+given baud), frames delivered / lost, corrupt frames that were delivered
+anyway (magic has no checksum), and the recovery cost per corruption
+event in bytes and milliseconds of audio.
+"""
+import argparse
+import random
+import struct
+import sys
+import threading
+import time
+from pathlib import Path
+from queue import Queue
+
+import numpy as np
+
+sys.path.insert(0, str(Path(__file__).resolve().parent / "webapp"))
+from backend.sources.serial_tlv import FRAMINGS, TLV_BATCH, SerialConfig, SerialTLVSource, frame_tlv  # noqa: E402
+from backend.test_pattern import pattern_counter  # noqa: E402
+
+
+class MemSerial:
+    """Enough of serial.Serial for the reader loops, backed by bytes."""
+
+    def __init__(self, data: bytes, chunk: int = 4096) -> None:
+        self._data = memoryview(data)
+        self._pos = 0
+        self._chunk = chunk
+        self.is_open = True
+
+    @property
+    def in_waiting(self) -> int:
+        return min(len(self._data) - self._pos, self._chunk)
+
+    def read(self, n: int = 1) -> bytes:
+        if self._pos >= len(self._data):
+            time.sleep(0.001)
+            return b""
+        b = bytes(self._data[self._pos:self._pos + n])
+        self._pos += len(b)
+        return b
+
+    def done(self) -> bool:
+        return self._pos >= len(self._data)
+
+    def close(self) -> None:
+        self.is_open = False
+
+
+def build_stream(framing: str, seconds: float, sr: int, blocks: int, spb: int) -> tuple[bytes, int]:
+    # COBS: a leading delimiter, as the host would have seen the previous frame end
+    frames = [b"\x00"] if framing == "cobs" else []
+    idx = 0
+    n = blocks * spb
+    while idx < seconds * sr:
+        hdr = struct.pack("<IHHQ", idx * 1000 // sr, blocks, spb, idx)
+        frames.append(frame_tlv(TLV_BATCH, hdr + pattern_counter(idx, n).astype("<i2").tobytes(), framing))
+        idx += n
+    return b"".join(frames), idx // n
+
+
+def corrupt(stream: bytes, ber: float, seed: int) -> tuple[bytes, int]:
+    """Flip single bits at the given bit-error rate; returns (stream, flips)."""
+    if ber <= 0:
+        return stream, 0
+    rng = random.Random(seed)
+    buf = bytearray(stream)
+    nbits = len(buf) * 8
+    flips = 0
+    pos = int(rng.expovariate(ber))
+    while pos < nbits:
+        buf[pos >> 3] ^= 1 << (pos & 7)
+        flips += 1
+        pos += 1 + int(rng.expovariate(ber))
+    return bytes(buf), flips
+
+
+def run(framing: str, stream: bytes, sr: int) -> dict:
+    src = SerialTLVSource()
+    src._cfg = SerialConfig(baud=0, sample_rate_hz=sr, framing=framing)
+    ser = MemSerial(stream)
+    src._ser = ser
+    src._q = Queue()  # unbounded: measure the parser, not the consumer
+    src._stop.clear()
+
+    frames = []
+    th = threading.Thread(target=src._reader_loop, daemon=True)
+    t0 = time.perf_counter()
+    th.start()
+    while True:
+        f = src.get_frame(timeout=0.05)
+        if f is None:
+            if ser.done():
+                break
+            continue
+        frames.append(f)
+    elapsed = time.perf_counter() - t0
+    src._stop.set()
+    th.join(timeout=1.0)
+
+    bad = 0
+    for f in frames:
+        got = np.asarray(f.samples_i16, dtype=np.int16)
+        if f.sample_index is None or not np.array_equal(got, pattern_counter(f.sample_index, got.size)):
+            bad += 1
+    return {
+        "elapsed": elapsed,
+        "delivered": len(frames),
+        "bad": bad,
+        "link": src.link_counters(),
+        "host_drops": src.dropped_frames(),
+    }
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--framing", choices=FRAMINGS + ("both",), default="both")
+    ap.add_argument("--seconds", type=float, default=30.0, help="audio per run")
+    ap.add_argument("--sample-rate", type=int, default=16000)
+    ap.add_argument("--blocks", type=int, default=4, help="blocks per batch (CONFIG_PDM_BATCH_MAX_BLOCKS)")
+    ap.add_argument("--spb", type=int, default=160, help="samples per block")
+    ap.add_argument("--ber", type=float, default=0.0, help="injected bit-error rate")
+    ap.add_argument("--baud", type=int, default=921600, help="for the x real time column")
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    framings = FRAMINGS if args.framing == "both" else (args.framing,)
+    print(f"{args.seconds:g} s @ {args.sample_rate} Hz, {args.blocks}x{args.spb} samples/frame, BER {args.ber:g}")
+    for fr in framings:
+        clean, nframes = build_stream(fr, args.seconds, args.sample_rate, args.blocks, args.spb)
+        stream, flips = corrupt(clean, args.ber, args.seed)
+        r = run(fr, stream, args.sample_rate)
+        link = r["link"]
+        mbs = len(stream) / r["elapsed"] / 1e6
+        line_bps = args.baud / 10
+        lost = nframes - r["delivered"] - r["host_drops"]
+        ms_per_frame = args.blocks * args.spb * 1000 / args.sample_rate
+        print(f"\n[{fr}] {len(stream)} bytes, {nframes} frames, overhead "
+              f"{len(clean) / (nframes * (16 + args.blocks * args.spb * 2)) - 1:.2%}")
+        print(f"  throughput      {mbs:.2f} MB/s ({len(stream) / r['elapsed'] / line_bps:.0f}x real time @ {args.baud})")
+        print(f"  delivered       {r['delivered']} frames ({r['host_drops']} host drops)")
+        print(f"  corrupt, kept   {r['bad']} frames")
+        print(f"  lost            {lost} frames")
+        print(f"  resyncs         {link.resyncs} (type {link.type_errors}, length {link.length_errors}, "
+              f"footer {link.footer_errors}, crc {link.crc_errors})")
+        if flips:
+            print(f"  per bit flip    {lost / flips:.2f} frames lost, {link.skipped_bytes / flips:.0f} bytes skipped, "
+                  f"{lost * ms_per_frame / flips:.1f} ms audio ({flips} flips)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
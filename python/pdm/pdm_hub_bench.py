@@ -0,0 +1,112 @@
+"""
+StreamHub contention benchmark: one pump thread writing a 16 kHz stream
+into the hub in real time while N websocket-like readers take ring
+snapshots at 30 Hz, each on its own thread.
+
+  python pdm_hub_bench.py --readers 1 8 32 64 --seconds 10
+
+The writer hands the hub one block every --block-ms (StreamHub._handle_frame,
+the pump thread's whole per-frame path); each reader calls ring_snapshot()
+for --read-ms of audio per tick. Per reader count it reports the writer's
+per-block time and the readers' per-snapshot time (p50 / p99 / max, us),
+ticks a reader missed because the previous one overran, and whether the
+writer kept real time.
+"""
+import argparse
+import sys
+import tempfile
+import threading
+import time
+from pathlib import Path
+
+import numpy as np
+
+sys.path.insert(0, str(Path(__file__).resolve().parent / "webapp"))
+from backend.recorder import CSVRecorder  # noqa: E402
+from backend.sources.base import AudioFrame  # noqa: E402
+from backend.streaming import StreamHub  # noqa: E402
+
+
+def pct(us: list[float]) -> str:
+    if not us:
+        return "-"
+    a = np.asarray(us)
+    return f"{np.percentile(a, 50):7.0f} {np.percentile(a, 99):7.0f} {a.max():8.0f}"
+
+
+def run(readers: int, seconds: float, sr: int, block_ms: int, read_ms: int, tick_hz: float) -> dict:
+    hub = StreamHub(wave_seconds=5, default_sr=sr, recorder=CSVRecorder(Path(tempfile.mkdtemp())))
+    stop = threading.Event()
+    spb = sr * block_ms // 1000
+    block = (np.arange(spb) % 2000).astype(np.int16)
+    w_us: list[float] = []
+    r_us: list[list[float]] = [[] for _ in range(readers)]
+    missed = [0] * readers
+    behind = [0.0]
+
+    def writer() -> None:
+        t_next = time.perf_counter()
+        idx = 0
+        while not stop.is_set():
+            frame = AudioFrame(timestamp_ms=idx * 1000 // sr, samples_i16=block, sample_index=idx,
+                               sample_rate_hz=sr)
+            t0 = time.perf_counter()
+            hub._handle_frame(frame)
+            w_us.append((time.perf_counter() - t0) * 1e6)
+            idx += spb
+            t_next += block_ms / 1000
+            behind[0] = max(behind[0], time.perf_counter() - t_next)
+            time.sleep(max(0.0, t_next - time.perf_counter()))
+
+    def reader(i: int) -> None:
+        period = 1 / tick_hz
+        t_next = time.perf_counter() + period * i / max(1, readers)  # spread the ticks
+        n = sr * read_ms // 1000
+        while not stop.is_set():
+            time.sleep(max(0.0, t_next - time.perf_counter()))
+            t0 = time.perf_counter()
+            hub.ring_snapshot(n)
+            r_us[i].append((time.perf_counter() - t0) * 1e6)
+            t_next += period
+            while t_next < time.perf_counter():
+                t_next += period
+                missed[i] += 1
+
+    threads = [threading.Thread(target=writer, daemon=True)]
+    threads += [threading.Thread(target=reader, args=(i,), daemon=True) for i in range(readers)]
+    for th in threads:
+        th.start()
+    time.sleep(seconds)
+    stop.set()
+    for th in threads:
+        th.join(timeout=1.0)
+    return {
+        "writer": w_us,
+        "reader": [u for us in r_us for u in us],
+        "missed": sum(missed),
+        "behind": behind[0],
+    }
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--readers", type=int, nargs="+", default=[1, 8, 32, 64])
+    ap.add_argument("--seconds", type=float, default=10.0)
+    ap.add_argument("--sample-rate", type=int, default=16000)
+    ap.add_argument("--block-ms", type=int, default=20)
+    ap.add_argument("--read-ms", type=int, default=1000, help="audio per snapshot")
+    ap.add_argument("--tick-hz", type=float, default=30.0)
+    args = ap.parse_args()
+
+    print(f"{args.sample_rate} Hz writer, {args.block_ms} ms blocks; readers take {args.read_ms} ms "
+          f"at {args.tick_hz:g} Hz; times in us (p50 p99 max)")
+    print(f"{'readers':>7} | {'writer per block':>24} | {'reader per snapshot':>24} | {'missed':>6} {'behind':>8}")
+    for n in args.readers:
+        r = run(n, args.seconds, args.sample_rate, args.block_ms, args.read_ms, args.tick_hz)
+        print(f"{n:7d} | {pct(r['writer']):>24} | {pct(r['reader']):>24} | {r['missed']:6d} "
+              f"{r['behind'] * 1000:6.1f}ms")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
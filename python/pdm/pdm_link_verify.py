@@ -0,0 +1,170 @@
+"""
+Link quality check for pdm_01 built with a test pattern
+(CONFIG_PDM_TEST_PATTERN_COUNTER / CONFIG_PDM_TEST_PATTERN_HASH).
+
+Every received sample is compared with the pattern at its device sample
+index, so the numbers hold for multi-hour runs at any baud rate / cable:
+
+  python pdm_link_verify.py /dev/ttyACM0 --baud 921600 --pattern hash --hours 4 --csv run.csv
+
+--rates 4000000,3000000,2000000 negotiates the fastest rate that passes the
+device's test burst first (CONFIG_PDM_LINK_RATE) and soaks the link there.
+
+Reported per interval and for the whole run: sustained wire throughput,
+bit-error rate over the checked samples, lost samples (index gaps),
+resyncs (bad type / bad length / footer mismatch / CRC error), bytes
+skipped while resyncing and frames dropped by the host queue.
+"""
+import argparse
+import csv
+import sys
+import time
+from pathlib import Path
+
+import numpy as np
+
+sys.path.insert(0, str(Path(__file__).resolve().parent / "webapp"))
+from backend.sources.serial_tlv import FRAMINGS, SerialTLVSource  # noqa: E402
+from backend.test_pattern import PATTERNS  # noqa: E402
+
+# popcount of every uint16 value
+POPCOUNT16 = np.array([bin(i).count("1") for i in range(1 << 16)], dtype=np.uint8)
+
+
+class Tally:
+    def __init__(self) -> None:
+        self.samples = 0
+        self.bit_errors = 0
+        self.bad_samples = 0
+        self.lost_samples = 0
+        self.gaps = 0
+        self.restarts = 0
+
+    def __sub__(self, other: "Tally") -> "Tally":
+        d = Tally()
+        for k in vars(self):
+            setattr(d, k, getattr(self, k) - getattr(other, k))
+        return d
+
+    def copy(self) -> "Tally":
+        c = Tally()
+        c.__dict__.update(self.__dict__)
+        return c
+
+
+def fmt_ber(bit_errors: int, samples: int) -> str:
+    bits = samples * 16
+    if bits == 0:
+        return "n/a"
+    if bit_errors == 0:
+        return f"<{1 / bits:.1e}"
+    return f"{bit_errors / bits:.2e}"
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port")
+    ap.add_argument("--baud", type=int, default=921600)
+    ap.add_argument("--pattern", choices=sorted(PATTERNS), default="counter")
+    ap.add_argument("--framing", choices=FRAMINGS, default="magic")
+    ap.add_argument("--rates", default="", help="baud rates to negotiate, fastest first (comma separated)")
+    ap.add_argument("--hours", type=float, default=0.0, help="run time, 0 = until Ctrl-C")
+    ap.add_argument("--report", type=float, default=10.0, help="seconds between report lines")
+    ap.add_argument("--csv", type=Path, help="append one row per report interval")
+    args = ap.parse_args()
+
+    expect = PATTERNS[args.pattern]
+    src = SerialTLVSource()
+    src.connect(args.port, baud=args.baud, framing=args.framing)
+    baud = args.baud
+    if args.rates:
+        baud = src.negotiate_baud([int(r) for r in args.rates.split(",")])
+
+    fields = ["elapsed_s", "wire_bytes_per_s", "line_util", "samples", "bit_errors", "ber",
+              "lost_samples", "gaps", "resyncs", "footer_errors", "crc_errors", "skipped_bytes", "host_drops"]
+    writer = None
+    if args.csv:
+        new = not args.csv.exists()
+        fp = open(args.csv, "a", newline="")
+        writer = csv.writer(fp)
+        if new:
+            writer.writerow(fields)
+
+    total = Tally()
+    next_index = None
+    t0 = time.monotonic()
+    t_report = t0
+    last_total = total.copy()
+    last_link = src.link_counters()
+    end = t0 + args.hours * 3600 if args.hours > 0 else None
+
+    print(f"{args.port} @ {baud}, pattern={args.pattern}, framing={args.framing}")
+    try:
+        while src.is_connected():
+            frame = src.get_frame(timeout=0.5)
+            now = time.monotonic()
+            if frame is not None and frame.sample_index is not None and frame.samples_i16.size:
+                got = np.asarray(frame.samples_i16, dtype=np.int16)
+                ref = expect(frame.sample_index, got.size)
+                diff = (got.view(np.uint16) ^ ref.view(np.uint16))
+                total.samples += got.size
+                total.bit_errors += int(POPCOUNT16[diff].sum(dtype=np.int64))
+                total.bad_samples += int(np.count_nonzero(diff))
+
+                if next_index is not None and frame.sample_index != next_index:
+                    if frame.sample_index > next_index:
+                        total.lost_samples += frame.sample_index - next_index
+                        total.gaps += 1
+                    else:
+                        total.restarts += 1
+                next_index = frame.sample_index + got.size
+
+            if now - t_report >= args.report:
+                link = src.link_counters()
+                d = total - last_total
+                dt = now - t_report
+                rate = (link.wire_bytes - last_link.wire_bytes) / dt
+                row = [
+                    round(now - t0, 1), round(rate), round(rate * 10 / baud, 3),
+                    d.samples, d.bit_errors, fmt_ber(d.bit_errors, d.samples),
+                    d.lost_samples, d.gaps, link.resyncs - last_link.resyncs,
+                    link.footer_errors - last_link.footer_errors,
+                    link.crc_errors - last_link.crc_errors,
+                    link.skipped_bytes - last_link.skipped_bytes,
+                    src.dropped_frames(),
+                ]
+                print("  ".join(f"{k}={v}" for k, v in zip(fields, row)), flush=True)
+                if writer:
+                    writer.writerow(row)
+                    fp.flush()
+                t_report, last_total, last_link = now, total.copy(), link
+
+            if end is not None and now >= end:
+                break
+    except KeyboardInterrupt:
+        pass
+    finally:
+        link = src.link_counters()
+        elapsed = max(time.monotonic() - t0, 1e-9)
+        src.disconnect()
+        if writer:
+            fp.close()
+
+    print("\n---- summary ----")
+    print(f"elapsed          {elapsed:.1f} s")
+    print(f"throughput       {link.wire_bytes / elapsed:.0f} B/s ({link.wire_bytes * 10 / elapsed / baud:.1%} of line)")
+    print(f"frames           {link.frames}")
+    print(f"samples checked  {total.samples}")
+    print(f"bit errors       {total.bit_errors} in {total.bad_samples} samples, BER {fmt_ber(total.bit_errors, total.samples)}")
+    print(f"lost samples     {total.lost_samples} in {total.gaps} gaps ({total.restarts} index restarts)")
+    print(f"resyncs          {link.resyncs} (type {link.type_errors}, length {link.length_errors}, "
+          f"footer {link.footer_errors}, crc {link.crc_errors})")
+    print(f"skipped bytes    {link.skipped_bytes}")
+    print(f"decode errors    {link.decode_errors} frames")
+    print(f"host drops       {src.dropped_frames()} frames")
+    ok = total.bit_errors == 0 and link.resyncs == 0 and link.decode_errors == 0 and total.lost_samples == 0
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,249 @@
+"""
+Host TLV parser benchmark: SerialTLVSource's reader thread against a byte
+corpus replayed at real link rates.
+
+The corpus is a raw capture of the device stream (--corpus, e.g. dumped
+with `cat /dev/ttyACM0 > corpus.bin`) or, by default, a synthetic one:
+PCM batch frames of the counter test pattern plus a TLV_STATS frame per
+second, like CONFIG_PDM_TEST_PATTERN_COUNTER with CONFIG_PDM_STATS. It is
+looped for --seconds at each baud, handed out as a UART would (bytes
+arrive at baud / 10 per second, read() waits for what it asked for):
+
+  python pdm_parser_bench.py --bauds 921600 2000000 4000000 --seconds 10
+
+Per baud it reports frames/s and MB/s delivered, the reader thread's CPU
+time as a share of one core (decoding into AudioFrames included), and
+how far behind the link it finished. A last run with the whole corpus
+available at once gives the parser's ceiling.
+
+With magic framing each baud runs twice on the same corpus (--parser):
+"current" is SerialTLVSource as it is, "reference" the byte-wise loop it
+replaced (read(1) header hunt, _read_exact for T, L, value and footer),
+kept here to compare against. COBS framing has only the current parser.
+"""
+import argparse
+import struct
+import sys
+import threading
+import time
+from pathlib import Path
+from queue import Queue
+
+sys.path.insert(0, str(Path(__file__).resolve().parent / "webapp"))
+from backend.sources.serial_tlv import (FRAME_FTR, FRAME_HDR, FRAMINGS, MAGIC_TYPES,  # noqa: E402
+                                        MAX_L, STATS_FMT, TLV_BATCH, TLV_STATS, SerialConfig,
+                                        SerialTLVSource, frame_tlv)
+from backend.test_pattern import pattern_counter  # noqa: E402
+
+
+class PacedSerial:
+    """Enough of serial.Serial for the reader loops, fed at baud / 10 bytes/s."""
+
+    def __init__(self, data: bytes, seconds: float, baud: int = 0, timeout: float = 0.2) -> None:
+        self._data = data
+        self._len = int(seconds * baud / 10) if baud else len(data)
+        self._bps = baud / 10
+        self._timeout = timeout
+        self._pos = 0
+        self._t0 = 0.0
+        self.reads = 0  # a syscall each on a real port
+        self.is_open = True
+
+    def _arrived(self) -> int:
+        if not self._bps:
+            return self._len
+        if not self._t0:
+            self._t0 = time.perf_counter()
+        return min(self._len, int((time.perf_counter() - self._t0) * self._bps))
+
+    @property
+    def in_waiting(self) -> int:
+        return self._arrived() - self._pos
+
+    def read(self, n: int = 1) -> bytes:
+        self.reads += 1
+        deadline = time.perf_counter() + self._timeout
+        while True:
+            avail = self._arrived() - self._pos
+            if avail >= n or self._arrived() == self._len or time.perf_counter() >= deadline:
+                break
+            time.sleep(min(0.001, (n - avail) / self._bps))
+        n = min(n, avail)
+        if n <= 0:
+            time.sleep(self._timeout if self.done() else 0)
+            return b""
+        # the corpus is looped: a read may wrap around its end
+        out = bytearray()
+        while len(out) < n:
+            at = (self._pos + len(out)) % len(self._data)
+            out += self._data[at:at + n - len(out)]
+        self._pos += n
+        return bytes(out)
+
+    def done(self) -> bool:
+        return self._pos >= self._len
+
+    def close(self) -> None:
+        self.is_open = False
+
+
+class ReferenceTLVSource(SerialTLVSource):
+    """SerialTLVSource with the byte-wise magic-framing reader it used to have."""
+
+    def _read_exact(self, n: int) -> bytes:
+        buf = bytearray()
+        while len(buf) < n and not self._stop.is_set():
+            chunk = self._ser.read(n - len(buf))
+            if chunk:
+                buf.extend(chunk)
+        return bytes(buf)
+
+    def _reader_loop_magic(self) -> None:
+        win = bytearray()  # sliding 4-byte window to find the header
+
+        while not self._stop.is_set():
+            hunted = len(win)
+            while not self._stop.is_set():
+                b = self._ser.read(1)
+                if not b:
+                    continue
+                hunted += 1
+                win += b
+                if len(win) > 4:
+                    del win[0]
+                if len(win) == 4 and int.from_bytes(win, "little") == FRAME_HDR:
+                    self._link.skipped_bytes += hunted - 4
+                    break
+            if self._stop.is_set():
+                break
+
+            t_b = self._read_exact(1)
+            l_bytes = self._read_exact(2)
+            if len(t_b) != 1 or len(l_bytes) != 2:
+                continue
+            t = t_b[0]
+            (L,) = struct.unpack("<H", l_bytes)
+            win.clear()
+            if t not in MAGIC_TYPES:
+                self._link.type_errors += 1
+                continue
+            if L > MAX_L:
+                self._link.length_errors += 1
+                continue
+
+            v = self._read_exact(L) if L else b""
+            ftr = self._read_exact(4)
+            if len(v) != L:
+                continue
+            if len(ftr) != 4 or int.from_bytes(ftr, "little") != FRAME_FTR:
+                self._link.footer_errors += 1
+                continue
+
+            self._rx_ns = time.monotonic_ns()
+            self._wire_bytes = 4 + 3 + L + 4
+            self._link.frames += 1
+            self._link.wire_bytes += self._wire_bytes
+            self._decode_tlv(t, L, v)
+
+
+PARSERS = {"current": SerialTLVSource, "reference": ReferenceTLVSource}
+
+
+def build_corpus(framing: str, seconds: float, sr: int, blocks: int, spb: int) -> bytes:
+    frames = [b"\x00"] if framing == "cobs" else []
+    idx = 0
+    n = blocks * spb
+    next_stats = sr
+    while idx < seconds * sr:
+        hdr = struct.pack("<IHHQ", idx * 1000 // sr, blocks, spb, idx)
+        frames.append(frame_tlv(TLV_BATCH, hdr + pattern_counter(idx, n).astype("<i2").tobytes(), framing))
+        idx += n
+        if idx >= next_stats:
+            frames.append(frame_tlv(TLV_STATS, bytes(STATS_FMT.size), framing))
+            next_stats += sr
+    return b"".join(frames)
+
+
+def run(parser: str, framing: str, corpus: bytes, sr: int, seconds: float, baud: int) -> dict:
+    src = PARSERS[parser]()
+    src._cfg = SerialConfig(baud=baud, sample_rate_hz=sr, framing=framing)
+    ser = PacedSerial(corpus, seconds, baud)
+    src._ser = ser
+    src._q = Queue()  # unbounded: measure the parser, not the consumer
+    src._stop.clear()
+
+    cpu = {}
+
+    def reader() -> None:
+        src._reader_loop()
+        cpu["s"] = time.thread_time()
+
+    th = threading.Thread(target=reader, daemon=True)
+    t0 = time.perf_counter()
+    th.start()
+    delivered = 0
+    while True:
+        f = src.get_frame(timeout=0.05)
+        if f is None:
+            if ser.done() and src._q.empty():
+                break
+            continue
+        delivered += 1
+    elapsed = time.perf_counter() - t0
+    src._stop.set()
+    th.join(timeout=1.0)
+
+    link = src.link_counters()
+    return {
+        "elapsed": elapsed,
+        "bytes": ser._len,
+        "frames": link.frames,
+        "delivered": delivered,
+        "cpu": cpu.get("s", 0.0),
+        "reads": ser.reads,
+        "resyncs": link.resyncs,
+    }
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--framing", choices=FRAMINGS, default="magic")
+    ap.add_argument("--parser", choices=("both",) + tuple(PARSERS), default="both",
+                    help="magic framing reader(s) to run (default: both)")
+    ap.add_argument("--corpus", type=Path, help="raw device stream to replay (default: synthetic)")
+    ap.add_argument("--bauds", type=int, nargs="+", default=[921600, 2000000, 4000000])
+    ap.add_argument("--seconds", type=float, default=10.0, help="link time per baud")
+    ap.add_argument("--sample-rate", type=int, default=16000)
+    ap.add_argument("--blocks", type=int, default=4, help="blocks per batch (CONFIG_PDM_BATCH_MAX_BLOCKS)")
+    ap.add_argument("--spb", type=int, default=320, help="samples per block")
+    args = ap.parse_args()
+
+    if args.corpus:
+        corpus = args.corpus.read_bytes()
+    else:
+        corpus = build_corpus(args.framing, 10.0, args.sample_rate, args.blocks, args.spb)
+    if args.framing == "cobs":
+        parsers = ["current"]
+    elif args.parser == "both":
+        parsers = list(PARSERS)
+    else:
+        parsers = [args.parser]
+    print(f"{args.framing} corpus: {len(corpus)} bytes, {args.seconds:g} s per baud")
+    print(f"{'baud':>9} {'parser':>9} {'frames/s':>9} {'MB/s':>6} {'reads/frame':>11} {'reader CPU':>10} "
+          f"{'behind':>8} {'resyncs':>7}")
+
+    for baud in args.bauds + [0]:
+        secs = args.seconds if baud else 0
+        label = baud if baud else "max"
+        for parser in parsers:
+            r = run(parser, args.framing, corpus, args.sample_rate, secs, baud)
+            wall = r["elapsed"]
+            behind = wall - secs if baud else 0.0
+            print(f"{label:>9} {parser:>9} {r['frames'] / wall:9.0f} {r['bytes'] / wall / 1e6:6.2f} "
+                  f"{r['reads'] / max(1, r['frames']):11.2f} {r['cpu'] / wall:10.1%} {behind:7.2f}s "
+                  f"{r['resyncs']:7d}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
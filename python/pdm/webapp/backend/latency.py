@@ -0,0 +1,91 @@
+from __future__ import annotations
+import threading
+from dataclasses import dataclass, field
+
+# Same layout as the firmware (latency/latency.h): bucket 0 is [0, 2) us,
+# bucket b is [2^b, 2^(b+1)) us, the last bucket is open ended.
+LAT_BUCKETS = 20
+
+# Firmware stage ids, in TLV_T_LAT_HIST order
+DEVICE_STAGES = ("capture", "queue", "encode", "link", "total")
+
+
+def bucket_of(us: int) -> int:
+    return min(max(us, 1).bit_length() - 1, LAT_BUCKETS - 1)
+
+
+def percentile_us(buckets: list[int], q: float) -> int | None:
+    """Upper edge of the bucket holding the q-quantile (coarse on purpose)."""
+    total = sum(buckets)
+    if total == 0:
+        return None
+    rank = q * total
+    run = 0
+    for b, n in enumerate(buckets):
+        run += n
+        if run >= rank:
+            return 2 << b
+    return 2 << (len(buckets) - 1)
+
+
+@dataclass
+class LatencyHist:
+    count: int = 0
+    max_us: int = 0
+    sum_us: int = 0
+    buckets: list[int] = field(default_factory=lambda: [0] * LAT_BUCKETS)
+
+    def add(self, us: int) -> None:
+        us = max(0, int(us))
+        self.count += 1
+        self.sum_us += us
+        self.max_us = max(self.max_us, us)
+        self.buckets[bucket_of(us)] += 1
+
+    def to_dict(self) -> dict:
+        return {
+            "count": self.count,
+            "mean_us": self.sum_us // self.count if self.count else None,
+            "p50_us": percentile_us(self.buckets, 0.50),
+            "p99_us": percentile_us(self.buckets, 0.99),
+            "max_us": self.max_us,
+            "buckets": list(self.buckets),
+        }
+
+
+class LatencyTracker:
+    """
+    Host half of the mic-to-websocket breakdown. Stages, all measured from
+    the moment the frame's footer was read off the serial port:
+      wire   : frame bytes * 10 / baud (estimate, the clocks are not shared)
+      decode : footer read -> AudioFrame queued by the source
+      hub    : footer read -> StreamHub._handle_frame
+      ws     : footer read -> newest samples sent to a websocket client
+    The device half (TLV_T_LAT_HIST) is stored as received.
+    """
+    HOST_STAGES = ("wire", "decode", "hub", "ws")
+
+    def __init__(self) -> None:
+        self._lock = threading.Lock()
+        self._host = {s: LatencyHist() for s in self.HOST_STAGES}
+        self._device: dict[str, dict] = {}
+
+    def record(self, stage: str, us: int) -> None:
+        with self._lock:
+            self._host[stage].add(us)
+
+    def set_device(self, hist: dict) -> None:
+        with self._lock:
+            self._device[hist["stage"]] = hist
+
+    def reset(self) -> None:
+        with self._lock:
+            self._host = {s: LatencyHist() for s in self.HOST_STAGES}
+            self._device = {}
+
+    def snapshot(self) -> dict:
+        with self._lock:
+            return {
+                "device": dict(self._device),
+                "host": {s: h.to_dict() for s, h in self._host.items()},
+            }
@@ -1,13 +1,16 @@
 from __future__ import annotations
 import asyncio
 import json
+import struct
+import time
 from pathlib import Path
+from typing import Optional
 from fastapi import FastAPI, WebSocket
 from fastapi.responses import HTMLResponse, FileResponse
 from fastapi.staticfiles import StaticFiles
 
 from .settings import SETTINGS
-from .sources.serial_tlv import SerialTLVSource
+from .sources.serial_tlv import SerialTLVSource, spectrum_band_edges
 from .recorder import CSVRecorder
 from .streaming import StreamHub
 
@@ -19,9 +22,17 @@ app.mount("/static", StaticFiles(directory=str(WEB_DIR)), name="static")
 
 # --- Core services ---
 recorder = CSVRecorder(SETTINGS.recordings_dir)
-hub = StreamHub(wave_seconds=SETTINGS.wave_seconds, default_sr=SETTINGS.default_sample_rate_hz, recorder=recorder)
+hub = StreamHub(wave_seconds=SETTINGS.wave_seconds, default_sr=SETTINGS.default_sample_rate_hz, recorder=recorder,
+                conceal=SETTINGS.conceal, max_conceal_seconds=SETTINGS.max_conceal_seconds,
+                silence_fill=SETTINGS.silence_fill, spectrogram_frames=SETTINGS.spectrogram_frames,
+                mfcc_frames=SETTINGS.mfcc_frames)
 
-serial_source = SerialTLVSource(log_cb=hub.add_log)
+serial_source = SerialTLVSource(log_cb=hub.add_log, stats_cb=hub.set_device_stats,
+                                latency_cb=hub.latency.set_device,
+                                stream_cfg_cb=hub.set_stream_config,
+                                spectrum_cb=hub.add_spectra,
+                                mfcc_cb=hub.add_mfcc,
+                                half_rate_cb=hub.add_half_rate)
 hub.set_source(serial_source)
 
 @app.get("/")
@@ -41,7 +52,18 @@ def status():
         "endpoint": st.endpoint,
         "baud": st.baud,
         "sample_rate_hz": st.sample_rate_hz,
+        "channels": st.channels,
         "last_timestamp_ms": st.last_timestamp_ms,
+        "dropped_frames": st.dropped_frames,
+        "lost_samples": st.lost_samples,
+        "gaps": st.gaps,
+        "silent_samples": st.silent_samples,
+        "spectra": st.spectra,
+        "mfcc_vectors": st.mfcc_vectors,
+        "half_rate_samples": st.half_rate_samples,
+        "clips": st.clips,
+        "decode_errors": serial_source.link_counters().decode_errors,
+        "device": st.device_stats,
         "recording": rec.enabled,          # ✅ only boolean
     }
 
@@ -50,10 +72,14 @@ def connect(cfg: dict):
     endpoint = str(cfg.get("endpoint", "")).strip()
     baud = int(cfg.get("baud", SETTINGS.default_baud))
     sr = int(cfg.get("sample_rate_hz", SETTINGS.default_sample_rate_hz))
+    framing = str(cfg.get("framing", SETTINGS.default_framing))
+    link_rates = [int(r) for r in cfg.get("link_rates", SETTINGS.link_rates)]
     if not endpoint:
         return {"ok": False, "error": "endpoint required"}, 400
 
-    hub.connect(endpoint, baud=baud, sample_rate_hz=sr)
+    hub.connect(endpoint, baud=baud, sample_rate_hz=sr, framing=framing)
+    if link_rates:
+        hub.set_baud(serial_source.negotiate_baud(link_rates))
 
     # ✅ start recording automatically (don’t return path)
     hub.start_recording()
@@ -67,28 +93,209 @@ def disconnect():
     return {"ok": True}
 
 
+@app.get("/api/latency")
+def latency():
+    return hub.latency.snapshot()
+
+@app.post("/api/latency/dump")
+def latency_dump(cfg: Optional[dict] = None):
+    """Asks the device for its histograms; they show up in /api/latency."""
+    reset = bool((cfg or {}).get("reset", False))
+    try:
+        serial_source.request_latency_dump(reset=reset)
+    except RuntimeError as e:
+        return {"ok": False, "error": str(e)}
+    if reset:
+        hub.latency.reset()
+    return {"ok": True}
+
+
+@app.get("/api/stream-config")
+def stream_config():
+    """Asks the device for its stream format (falls back to the last ACK)."""
+    try:
+        return {"ok": True, **serial_source.configure_stream(timeout=2.0)}
+    except (RuntimeError, TimeoutError) as e:
+        return {"ok": False, "error": str(e), **(hub.status().stream_config or {})}
+
+@app.post("/api/stream-config")
+def set_stream_config(cfg: dict):
+    """
+    Restarts the device stream, e.g. {"block_ms": 10} or
+    {"sample_rate_hz": 32000, "block_ms": 40}. Omitted fields keep their
+    value. Returns the format the device runs with afterwards.
+    """
+    try:
+        ack = serial_source.configure_stream(
+            sample_rate_hz=int(cfg.get("sample_rate_hz", 0)),
+            block_ms=int(cfg.get("block_ms", 0)),
+            channels=int(cfg.get("channels", 0)),
+            pcm_width_bits=int(cfg.get("pcm_width_bits", 0)),
+        )
+    except (RuntimeError, TimeoutError) as e:
+        return {"ok": False, "error": str(e)}
+    return {"ok": ack["status"] == 0, **ack}
+
+
+@app.post("/api/noise-suppression")
+def noise_suppression(cfg: dict):
+    """
+    {"enabled": true/false}. Only devices built with CONFIG_PDM_NS act on
+    it; the cost per block shows up as ns_cycles_per_block in the status.
+    """
+    try:
+        serial_source.set_noise_suppression(bool(cfg.get("enabled", True)))
+    except RuntimeError as e:
+        return {"ok": False, "error": str(e)}
+    return {"ok": True}
+
+
+@app.post("/api/trigger")
+def trigger(cfg: dict):
+    """
+    {"fire": true} starts a clip on a device built with CONFIG_PDM_TRIGGER,
+    {"fire": false} re-arms it (needed when PDM_TRIGGER_POST_MS is 0).
+    """
+    try:
+        serial_source.trigger(bool(cfg.get("fire", True)))
+    except RuntimeError as e:
+        return {"ok": False, "error": str(e)}
+    return {"ok": True}
+
+
+@app.post("/api/link-rate")
+def link_rate(cfg: dict):
+    """Negotiates a faster UART rate, e.g. {"rates": [4000000, 3000000, 2000000]}."""
+    rates = [int(r) for r in cfg.get("rates", SETTINGS.link_rates)]
+    try:
+        baud = serial_source.negotiate_baud(rates)
+    except RuntimeError as e:
+        return {"ok": False, "error": str(e)}
+    hub.set_baud(baud)
+    return {"ok": True, "baud": baud}
+
+
+@app.get("/api/spectrogram")
+def spectrogram(frames: int = 200):
+    """
+    Newest device spectra (firmware built with PDM_CODEC_SPECTRUM), oldest
+    first. levels are the raw u8 codes, dBFS = level / 2 - 127.5; row k
+    covers freqs_hz[k]..freqs_hz[k + 1].
+    """
+    snap = hub.spectrogram_snapshot(frames)
+    if not snap:
+        return {"frames": []}
+    last = snap[-1]
+    sr = last.sample_rate_hz or hub.status().sample_rate_hz
+    n = len(last.levels)
+    edges = spectrum_band_edges(last.fft_size, n if last.banded else 0)
+    return {
+        "fft_size": last.fft_size,
+        "bands": n if last.banded else 0,
+        "sample_rate_hz": sr,
+        "freqs_hz": [e * sr / last.fft_size for e in edges],
+        "frames": [
+            {"sample_index": f.sample_index, "timestamp_ms": f.timestamp_ms, "levels": list(f.levels)}
+            for f in snap if len(f.levels) == n
+        ],
+    }
+
+
+@app.get("/api/mfcc")
+def mfcc(frames: int = 100):
+    """
+    Newest device MFCC vectors (firmware built with PDM_CODEC_MFCC), oldest
+    first, for feeding models without computing features on the host.
+    sample_index is the end of each vector's analysis frame.
+    """
+    snap = hub.mfcc_snapshot(frames)
+    return {
+        "hop": snap[-1].hop if snap else None,
+        "frames": [
+            {"sample_index": f.sample_index, "timestamp_ms": f.timestamp_ms, "coefs": f.coefs}
+            for f in snap
+        ],
+    }
+
+
+@app.get("/api/half-rate")
+def half_rate(samples: int = 4000):
+    """
+    Newest samples of the device's half-rate copy of the stream (firmware
+    built with PDM_DECIM_HALF_RATE), channel 0, oldest first. sample_index
+    counts at that rate.
+    """
+    sr, first, data = hub.half_rate_snapshot(samples)
+    return {"sample_rate_hz": sr, "sample_index": first, "samples": data.tolist()}
+
+
+# Binary websocket message: WS_PCM_HDR then int16 LE channel 0 samples.
+#   version u8, reserved u8, header bytes u16, seq u32 (per connection),
+#   first sample u64 (hub ring cursor), sample_rate_hz u32,
+#   device timestamp_ms u32 of the first sample (WS_NO_TS = none)
+# Consecutive messages are contiguous unless first sample jumps ahead
+# (the client fell behind and was skipped forward).
+# Text messages stay JSON ({"type": "log", ...}). web/app.js decodes both.
+WS_PCM_HDR = struct.Struct("<BBHIQII")
+WS_PCM_VERSION = 1
+WS_NO_TS = 0xFFFFFFFF
+WS_IDLE_S = 0.25  # logs still go out this often without audio
+
+
 @app.websocket("/ws")
 async def ws_stream(ws: WebSocket):
+    """
+    Pushes each client exactly the samples it has not had yet: a cursor
+    into the hub ring, woken by the pump thread on new data. A send only
+    starts after the previous one completed, so a slow client accumulates
+    backlog in the ring, not in a queue; past SETTINGS.ws_backlog_seconds
+    its cursor skips ahead to the newest audio.
+    """
     await ws.accept()
+    loop = asyncio.get_running_loop()
+    data_ready = asyncio.Event()
+
+    def on_data() -> None:  # pump thread
+        try:
+            loop.call_soon_threadsafe(data_ready.set)
+        except RuntimeError:
+            pass  # loop closed, the handler is on its way out
+
+    hub.add_data_listener(on_data)
+    cursor = hub.ring_cursor()
+    last_rx_ns = None
+    seq = 0
+    try:
+        while True:
+            try:
+                await asyncio.wait_for(data_ready.wait(), timeout=WS_IDLE_S)
+            except asyncio.TimeoutError:
+                pass
+            data_ready.clear()
+
+            # send pending logs first
+            logs = hub.pop_logs(30)
+            for item in logs:
+                await ws.send_text(json.dumps({"type": "log", "data": item}))
+
+            end = hub.ring_cursor()
+            if end <= cursor:
+                continue
+            st = hub.status()
+            cursor = max(cursor, end - int(st.sample_rate_hz * SETTINGS.ws_backlog_seconds))
+            first, chunk = hub.ring_read(cursor, end)
+            cursor = end
+            if chunk.size == 0:
+                continue
+            ts = hub.timestamp_at(first)
+            hdr = WS_PCM_HDR.pack(WS_PCM_VERSION, 0, WS_PCM_HDR.size, seq, first, st.sample_rate_hz,
+                                  WS_NO_TS if ts is None else ts & 0xFFFFFFFF)
+            await ws.send_bytes(hdr + chunk.astype("<i2", copy=False).tobytes())
+            seq = (seq + 1) & 0xFFFFFFFF
 
-    while True:
-        await asyncio.sleep(1/30)
-
-        # send pending logs first
-        logs = hub.pop_logs(30)
-        for item in logs:
-            await ws.send_text(json.dumps({"type": "log", "data": item}))
-
-        st = hub.status()
-        if not st.connected:
-            continue
-
-        chunk = hub.ring_snapshot(max_samples=int(st.sample_rate_hz * 0.02))
-        await ws.send_text(json.dumps({
-            "type": "frame",
-            "data": {
-                "samples": chunk,
-                "timestamp_ms": st.last_timestamp_ms,
-                "sample_rate_hz": st.sample_rate_hz
-            }
-        }))
\ No newline at end of file
+            rx_ns = hub.last_rx_ns()
+            if rx_ns is not None and rx_ns != last_rx_ns:
+                hub.latency.record("ws", (time.monotonic_ns() - rx_ns) // 1000)
+                last_rx_ns = rx_ns
+    finally:
+        hub.remove_data_listener(on_data)
\ No newline at end of file
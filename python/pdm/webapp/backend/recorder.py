@@ -5,17 +5,22 @@ from dataclasses import dataclass
 from pathlib import Path
 from typing import Optional
 
+import numpy as np
+
 @dataclass
 class RecordingState:
     enabled: bool = False
     path: Optional[Path] = None
     sample_index: int = 0
     sample_rate_hz: int = 16000
+    channels: int = 1
 
 class CSVRecorder:
     """
     Writes one row per sample:
       timestamp_ms, sample_index, sample_i16
+    or, for multi-channel streams, one column per channel:
+      timestamp_ms, sample_index, ch0_i16, ch1_i16, ...
     """
     def __init__(self, recordings_dir: Path):
         self.recordings_dir = recordings_dir
@@ -24,21 +29,26 @@ class CSVRecorder:
         self._fp = None
         self._writer = None
 
-    def start(self, sample_rate_hz: int) -> Path:
+    def start(self, sample_rate_hz: int, channels: int = 1) -> Path:
         if self.state.enabled:
             return self.state.path  # already recording
 
         ts = time.strftime("%Y%m%d_%H%M%S")
-        path = self.recordings_dir / f"audio_{ts}_{sample_rate_hz}hz.csv"
+        suffix = f"_{channels}ch" if channels > 1 else ""
+        path = self.recordings_dir / f"audio_{ts}_{sample_rate_hz}hz{suffix}.csv"
         fp = open(path, "w", newline="")
         writer = csv.writer(fp)
-        writer.writerow(["timestamp_ms", "sample_index", "sample_i16"])
+        if channels > 1:
+            writer.writerow(["timestamp_ms", "sample_index"] + [f"ch{c}_i16" for c in range(channels)])
+        else:
+            writer.writerow(["timestamp_ms", "sample_index", "sample_i16"])
 
         self.state = RecordingState(
             enabled=True,
             path=path,
             sample_index=0,
-            sample_rate_hz=sample_rate_hz
+            sample_rate_hz=sample_rate_hz,
+            channels=channels,
         )
         self._fp = fp
         self._writer = writer
@@ -56,13 +66,26 @@ class CSVRecorder:
             self._writer = None
             self.state.enabled = False
 
-    def write_frame(self, timestamp_ms: int | None, samples_i16: list[int]) -> None:
-        if not self.state.enabled or self._writer is None:
+    def write_frame(self, timestamp_ms: int | None, samples_i16: np.ndarray) -> None:
+        if not self.state.enabled or self._fp is None:
             return
 
         # If device doesn't send timestamp, you can store blank or server time.
         ts = timestamp_ms if timestamp_ms is not None else ""
 
-        for s in samples_i16:
-            self._writer.writerow([ts, self.state.sample_index, int(s)])
-            self.state.sample_index += 1
+        ch = self.state.channels
+        n = samples_i16.size // ch
+        if n == 0:
+            return
+        # the rows csv.writer would write, formatted in one go
+        rows = np.empty((n, ch + 1), dtype=np.int64)
+        rows[:, 0] = np.arange(self.state.sample_index, self.state.sample_index + n)
+        rows[:, 1:] = samples_i16[:n * ch].reshape(n, ch)
+        row_fmt = f"{ts}" + ",%d" * (ch + 1) + "\r\n"
+        self._fp.write((row_fmt * n) % tuple(rows.ravel().tolist()))
+        self.state.sample_index += n
+
+    def skip(self, n: int) -> None:
+        """Advance sample_index over n samples that have no rows (long gaps)."""
+        if self.state.enabled:
+            self.state.sample_index += n
@@ -0,0 +1,80 @@
+from __future__ import annotations
+
+import numpy as np
+
+READ_RETRIES = 3  # a reader lapped this often in a row gets nothing
+
+
+class SampleRing:
+    """
+    Fixed-size int16 history with a monotonically increasing write cursor:
+    sample k of the stream lives in slot k % capacity while
+    max(start, end - capacity) <= k < end. A ring that replaces another
+    starts where it ended, so cursors held by readers never go back.
+
+    One writer, any number of readers, no lock between them. The writer
+    publishes `_claim` (the end after the write in progress) before it
+    copies and `end` after. A reader copies what it wants below `end`,
+    then re-reads `_claim`: samples the writer may have overwritten during
+    the copy (below _claim - capacity) are dropped from the front, and a
+    copy the writer lapped completely is retried, seqlock style. Nothing
+    overwritten is ever returned.
+    """
+    def __init__(self, capacity: int, start: int = 0):
+        self._buf = np.zeros(max(1, capacity), dtype=np.int16)
+        self._start = start
+        self._claim = start
+        self.end = start
+
+    def __len__(self) -> int:
+        return min(self.end - self._start, self._buf.size)
+
+    @property
+    def capacity(self) -> int:
+        return self._buf.size
+
+    def extend(self, samples: np.ndarray) -> None:
+        """Writer only."""
+        cap = self._buf.size
+        n = samples.size
+        if n > cap:
+            samples = samples[n - cap:]
+        end = self.end + n
+        self._claim = end
+        pos = (end - samples.size) % cap
+        first = min(samples.size, cap - pos)
+        self._buf[pos:pos + first] = samples[:first]
+        self._buf[:samples.size - first] = samples[first:]
+        self.end = end
+
+    def read(self, start: int, end: int) -> tuple[int, np.ndarray]:
+        """
+        Copy of samples [start, end), clipped to what the ring still holds:
+        (cursor of the first sample returned, samples).
+        """
+        for _ in range(READ_RETRIES):
+            end = min(end, self.end)
+            start = max(start, end - self._buf.size, self._start)
+            out = self._copy(start, end)
+            oldest = self._claim - self._buf.size
+            if oldest <= start:
+                return start, out
+            if oldest < end:
+                # the writer lapped the front of the copy; the rest is intact
+                return oldest, out[oldest - start:]
+            start = oldest
+        return end, np.empty(0, dtype=np.int16)
+
+    def latest(self, n: int) -> np.ndarray:
+        """Copy of the newest n samples (fewer if the ring holds fewer)."""
+        end = self.end
+        return self.read(end - max(0, n), end)[1]
+
+    def _copy(self, start: int, end: int) -> np.ndarray:
+        cap = self._buf.size
+        if end <= start:
+            return np.empty(0, dtype=np.int16)
+        a, b = start % cap, end % cap
+        if a < b or b == 0:
+            return self._buf[a:b or cap].copy()
+        return np.concatenate((self._buf[a:], self._buf[:b]))
@@ -4,8 +4,16 @@ from pathlib import Path
 @dataclass(frozen=True)
 class Settings:
     default_baud: int = 921600
+    default_framing: str = "magic"        # must match CONFIG_PDM_FRAMING_* ("magic" / "cobs")
+    link_rates: tuple = ()                # offered after connect, fastest first, e.g. (4000000, 3000000, 2000000)
     default_sample_rate_hz: int = 16000   # used for display scaling & recording metadata
     wave_seconds: float = 2.0             # browser window
+    ws_backlog_seconds: float = 0.5       # a websocket client further behind skips ahead
+    conceal: str = "interp"               # lost samples: "interp" (linear) or "silence"
+    max_conceal_seconds: float = 5.0      # longer gaps only advance the sample index
+    silence_fill: str = "noise"           # device VAD silence: "noise" (at the device noise floor) or "zeros"
+    spectrogram_frames: int = 500         # device spectra kept for /api/spectrogram (10 s of 20 ms blocks)
+    mfcc_frames: int = 1000               # device MFCC vectors kept for /api/mfcc (10 s at a 10 ms hop)
     recordings_dir: Path = Path(__file__).resolve().parents[1] / "recordings"
 
 SETTINGS = Settings()
\ No newline at end of file
@@ -3,14 +3,60 @@ from abc import ABC, abstractmethod
 from dataclasses import dataclass
 from typing import Optional, Iterable
 
+import numpy as np
+
 @dataclass
 class AudioFrame:
     """
     A chunk of PCM audio.
-    samples: list[int] or bytes; we standardize to list[int] in the app.
+    samples_i16 is an int16 array, where possible a read-only view of the
+    received frame (np.frombuffer): copy it before writing to it.
+    """
+    timestamp_ms: Optional[int]
+    samples_i16: np.ndarray
+    # device running sample index of samples_i16[0]; None if not provided
+    sample_index: Optional[int] = None
+    # latency tracing (time.monotonic_ns), None when the source has no wire
+    rx_ns: Optional[int] = None      # frame fully read
+    queued_ns: Optional[int] = None  # decoded and handed to frames()
+    wire_bytes: int = 0              # framed size on the link
+    # stream format at the device when this frame was captured; samples_i16
+    # is interleaved when channels > 1. None = source doesn't know.
+    sample_rate_hz: Optional[int] = None
+    channels: int = 1
+    # VAD gated silence (device TLV_SILENCE): samples_i16 is empty and the
+    # frame stands for this many samples per channel at the device noise floor
+    silent_samples: int = 0
+    noise_floor_rms: int = 0
+    # first frame of a triggered clip (device TLV_TRIGGER_EVENT): the jump in
+    # sample_index ahead of it is audio the device chose not to send
+    clip_start: bool = False
+
+@dataclass
+class SpectrumFrame:
+    """
+    One device spectrum (TLV_SPECTRUM, firmware codec/spectrum.h) of the
+    newest fft_size samples up to sample_index + block_samples.
+    levels: u8 per bin or log band, dBFS = level / 2 - 127.5.
     """
     timestamp_ms: Optional[int]
-    samples_i16: list[int]  # int16 values
+    sample_index: int
+    block_samples: int
+    fft_size: int
+    banded: bool
+    levels: bytes
+    sample_rate_hz: Optional[int] = None
+
+@dataclass
+class MfccFrame:
+    """
+    One device MFCC vector (TLV_MFCC, firmware codec/mfcc.h) of the frame
+    ending at sample_index; frames are hop samples apart.
+    """
+    timestamp_ms: Optional[int]
+    sample_index: int
+    hop: int
+    coefs: list[float]  # c0.., orthonormal DCT of ln mel energies
 
 class AudioSource(ABC):
     @abstractmethod
@@ -30,6 +76,10 @@ class AudioSource(ABC):
     def is_connected(self) -> bool:
         raise NotImplementedError
 
+    def dropped_frames(self) -> int:
+        """Frames lost inside the source (e.g. its queue overflowed)."""
+        return 0
+
     @abstractmethod
     def frames(self) -> Iterable[AudioFrame]:
         """
@@ -1,34 +1,304 @@
 from __future__ import annotations
+import math
+import os
 import struct
 import threading
 import time
+import zlib
 from dataclasses import dataclass
+from itertools import accumulate
 from typing import Optional, Iterable
 from queue import Queue, Empty
 
+import numpy as np
 import serial
 from serial.tools import list_ports
 
-from .base import AudioSource, AudioFrame
+from .base import AudioSource, AudioFrame, SpectrumFrame, MfccFrame
+from ..latency import DEVICE_STAGES, percentile_us
+from ..test_pattern import pattern_hash
 from typing import Optional, Callable
 
-TLV_PCM = 0x01  # V = int16 LE PCM bytes
-TLV_TS  = 0x02  # V = uint32 LE timestamp ms
+TLV_PCM   = 0x01  # V = int16 LE PCM bytes
+TLV_TS    = 0x02  # V = uint32 LE timestamp ms
+TLV_BATCH = 0x03  # V = first_ts_ms u32 + block_count u16 + samples_per_block u16
+                  #     + first_sample u64 + PCM
+TLV_ADPCM = 0x04  # V = same header + block_count IMA-ADPCM blocks
+TLV_LOSSLESS = 0x05  # V = same header + block_count fixed-LPC/Rice blocks
+TLV_SILENCE = 0x06  # V = same header + noise_floor_rms u16, blocks the VAD held back
+TLV_SPECTRUM = 0x07  # V = same header + block_count spectrum frames (SPECTRUM_HDR + levels)
+TLV_MFCC = 0x08  # V = same header + block_count MFCC blocks (MFCC_HDR + int16 Q7 vectors)
+TLV_PCM_HALF = 0x09  # V = same header + raw PCM at half the stream rate (CONFIG_PDM_DECIM_HALF_RATE)
+TLV_STATS = 0x10  # V = pipeline health counters (firmware stats/stats.h)
+TLV_LAT_HIST = 0x11  # V = one latency histogram (firmware latency/latency.h)
+TLV_STREAM_CFG_ACK = 0x12  # V = status i32 + applied stream config, see STREAM_ACK
+TLV_LINK_RATE_ACK = 0x13  # V = status i32 + baud u32 + boot_baud u32
+TLV_LINK_TEST = 0x14  # V = LINK_TEST_HDR + int16 pattern_hash(first + i)
+TLV_TRIGGER_EVENT = 0x15  # V = TRIGGER_EVENT, a triggered clip starts (CONFIG_PDM_TRIGGER)
+TLV_SYNC  = 0x7F  # V = ASCII "SYNC"
+
+# host -> device
+TLV_LAT_DUMP = 0x40  # V = flags u8, bit0 = reset after dump
+TLV_STREAM_CFG = 0x41  # V = STREAM_CFG, 0 = keep current; empty = query
+TLV_LINK_RATE = 0x42  # V = baud u32, 0 = keepalive
+TLV_LINK_CONFIRM = 0x43  # V = ok u8, sent at the new rate
+TLV_NS_CTRL = 0x44  # V = enable u8, device noise suppression on / off
+TLV_TRIGGER_CTRL = 0x45  # V = fire u8, 1 = trigger now, 0 = re-arm
+
+BATCH_HDR = struct.Struct("<IHHQ")
+
+# Fields are only ever appended on the device side; extra bytes are ignored
+STATS_FMT = struct.Struct("<IIIIHHHHIHH")
+STATS_FIELDS = (
+    "uptime_ms", "blocks_captured", "blocks_dropped", "dmic_errors",
+    "audio_q_hwm", "audio_q_len", "slab_min_free", "slab_blocks",
+    "tx_bytes_per_s", "cpu_capture_permille", "cpu_tx_permille",
+)
+# appended fields in the order the firmware added them, parsed when the device sends them
+STATS_EXT = (
+    (struct.Struct("<I"), ("blocks_silent",)),
+    (struct.Struct("<II"), ("ns_cycles_per_block", "cycles_per_s")),
+    (struct.Struct("<HHI"), ("level_peak", "level_rms", "meter_dropped")),
+)
+
+SILENCE_FLOOR = struct.Struct("<H")  # after BATCH_HDR in TLV_SILENCE
+
+# sources u8 (bit per TRIGGER_SRCS), reserved u8, pre-roll blocks u16, clip first sample u64
+TRIGGER_EVENT = struct.Struct("<BBHQ")
+TRIGGER_SRCS = ("level", "gpio", "host")
+
+# Spectrum frames (firmware codec/spectrum.h): nbins, log2(fft_size), flags
+SPECTRUM_HDR = struct.Struct("<HBB")
+SPECTRUM_FLAG_BANDS = 0x01
+
+# MFCC blocks (firmware codec/mfcc.h): count, coefs, hop, first_end
+MFCC_HDR = struct.Struct("<BBHH")
+MFCC_COEF_SCALE = 1 / 128  # Q7
+
+LAT_HDR = struct.Struct("<BBHIIQ")  # stage, n_buckets, reserved, count, max_us, sum_us
+
+STREAM_CFG = struct.Struct("<IHBB")  # rate_hz, block_ms, channels, width_bits
+STREAM_ACK = struct.Struct("<iIHBBHH")
+STREAM_ACK_FIELDS = (
+    "status", "sample_rate_hz", "block_ms", "channels", "pcm_width_bits",
+    "block_bytes", "pool_blocks",
+)
+
+# Baud negotiation (firmware link_rate/link_rate.h)
+LINK_ACK = struct.Struct("<iII")      # status, baud, boot_baud
+LINK_TEST_HDR = struct.Struct("<BBHI")  # seq, count, reserved, first
+LINK_CONFIRM_S = 0.5 + 0.5  # CONFIG_PDM_LINK_RATE_CONFIRM_MS + margin
+LINK_KEEPALIVE_S = 1.0      # well inside CONFIG_PDM_LINK_RATE_IDLE_MS
 
 FRAME_HDR = 0xAA55AA55
 FRAME_FTR = 0xA5A5A5A5
-MAX_L = 4096
+MAX_L = 16384  # batches of up to 8 blocks of CONFIG_PDM_BLOCK_MAX_BYTES (1280)
+
+# ---- Framing (firmware tlv_link/tlv_link.h, CONFIG_PDM_FRAMING_*) ----
+#   magic: FRAME_HDR + T + L + V + FRAME_FTR, no checksum
+#   cobs : COBS(T + L + V + CRC32 LE) + 0x00, CRC-32/IEEE (zlib.crc32) over T..V
+FRAMINGS = ("magic", "cobs")
+COBS_TL = struct.Struct("<BH")
+COBS_MAX_ENC = MAX_L + MAX_L // 254 + 16
+MAGIC_HDR = struct.pack("<I", FRAME_HDR)
+MAGIC_FTR = struct.pack("<I", FRAME_FTR)
+MAGIC_TL = struct.Struct("<BH")
+MAGIC_HDR_TL = len(MAGIC_HDR) + MAGIC_TL.size
+MAGIC_MIN_FRAME = MAGIC_HDR_TL + len(MAGIC_FTR)
+# a FRAME_HDR match followed by any other type is a false hit
+MAGIC_TYPES = frozenset((TLV_TS, TLV_PCM, TLV_BATCH, TLV_ADPCM, TLV_LOSSLESS, TLV_SILENCE,
+                         TLV_SPECTRUM, TLV_MFCC, TLV_PCM_HALF, TLV_STATS, TLV_LAT_HIST, TLV_STREAM_CFG_ACK,
+                         TLV_LINK_RATE_ACK, TLV_LINK_TEST, TLV_TRIGGER_EVENT, TLV_SYNC))
+
+
+def cobs_encode(raw: bytes) -> bytes:
+    out = bytearray([0])
+    code_i, code = 0, 1
+    for b in raw:
+        if b:
+            out.append(b)
+            code += 1
+        if not b or code == 0xFF:
+            out[code_i] = code
+            code_i = len(out)
+            out.append(0)
+            code = 1
+    out[code_i] = code
+    return bytes(out)
+
+
+def cobs_decode(enc: bytes) -> bytes:
+    """Decodes one frame (without the 0x00 delimiter); ValueError if malformed."""
+    out = bytearray()
+    i, n = 0, len(enc)
+    while i < n:
+        code = enc[i]
+        j = i + code
+        if code == 0 or j > n:
+            raise ValueError("bad COBS code")
+        out += enc[i + 1:j]
+        i = j
+        if code != 0xFF and i < n:
+            out.append(0)
+    return bytes(out)
+
+
+def frame_tlv(t: int, v: bytes, framing: str = "magic") -> bytes:
+    """One framed TLV as the firmware would send it (also used host -> device)."""
+    if framing == "cobs":
+        raw = COBS_TL.pack(t, len(v)) + v
+        return cobs_encode(raw + struct.pack("<I", zlib.crc32(raw))) + b"\x00"
+    return struct.pack("<IBH", FRAME_HDR, t, len(v)) + v + struct.pack("<I", FRAME_FTR)
+
+# ---- IMA-ADPCM (firmware codec/ima_adpcm.c) ----
+IMA_STEP = np.array([
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+], dtype=np.int32)
+IMA_INDEX = [-1, -1, -1, -1, 2, 4, 6, 8] * 2
+IMA_HDR = struct.Struct("<hBx")  # predictor (= first sample), step index
+
+
+def ima_block_bytes(n: int) -> int:
+    return IMA_HDR.size + n // 2
+
+
+def ima_adpcm_decode_block(block: bytes, n: int) -> np.ndarray:
+    """
+    Decodes one self-contained IMA-ADPCM block of n samples.
+    Only the step-index walk is sequential; the reconstruction is a
+    vectorised cumulative sum, re-run sample by sample only if it clips.
+    """
+    pred0, idx0 = IMA_HDR.unpack_from(block)
+    raw = np.frombuffer(block, dtype=np.uint8, offset=IMA_HDR.size)
+    codes = np.empty(raw.size * 2, dtype=np.int32)
+    codes[0::2] = raw & 0x0F
+    codes[1::2] = raw >> 4
+    codes = codes[: n - 1]
+
+    idx = np.fromiter(
+        accumulate((IMA_INDEX[c] for c in codes.tolist()),
+                   lambda a, d: min(88, max(0, a + d)), initial=idx0),
+        dtype=np.int32, count=n,
+    )
+    step = IMA_STEP[idx[:-1]]
+    vpdiff = ((step >> 3)
+              + np.where(codes & 4, step, 0)
+              + np.where(codes & 2, step >> 1, 0)
+              + np.where(codes & 1, step >> 2, 0))
+    diff = np.where(codes & 8, -vpdiff, vpdiff)
+
+    out = np.empty(n, dtype=np.int32)
+    out[0] = pred0
+    np.cumsum(diff, out=out[1:])
+    out[1:] += pred0
+    if n > 1 and (out.min() < -32768 or out.max() > 32767):
+        pred = pred0
+        for i, d in enumerate(diff.tolist(), start=1):
+            pred = min(32767, max(-32768, pred + d))
+            out[i] = pred
+    return out.astype(np.int16)
+
+
+# ---- Lossless fixed-LPC + Rice (firmware codec/fixed_rice.c) ----
+RICE_HDR = struct.Struct("<HBB")  # block len, order (0xFF = verbatim), rice k
+RICE_VERBATIM = 0xFF
+
+
+def fixed_rice_decode_block(block: bytes, n: int) -> tuple[np.ndarray, int]:
+    """
+    Decodes one lossless block of n samples; returns (samples, block bytes).
+    Rice codes are walked over a '0'/'1' string so the unary scan is a
+    C-level str.find; the predictor is undone with order cumulative sums.
+    """
+    length, order, k = RICE_HDR.unpack_from(block)
+    if order == RICE_VERBATIM:
+        return np.frombuffer(block, dtype="<i2", count=n, offset=RICE_HDR.size).astype(np.int16), length
+    if order > 4 or length > len(block):
+        raise ValueError(f"bad lossless block (order={order}, len={length})")
+
+    off = RICE_HDR.size + 2 * order
+    warm = np.frombuffer(block, dtype="<i2", count=order, offset=RICE_HDR.size).astype(np.int64)
+    payload = block[off:length]
+    bits = format(int.from_bytes(payload, "big"), f"0{len(payload) * 8}b") if payload else ""
+
+    n_res = n - order
+    u = np.empty(n_res, dtype=np.int64)
+    pos = 0
+    for i in range(n_res):
+        one = bits.find("1", pos)
+        if one < 0:
+            raise ValueError("truncated Rice stream")
+        q = one - pos
+        pos = one + 1
+        rem = int(bits[pos:pos + k], 2) if k else 0
+        pos += k
+        u[i] = (q << k) | rem
+    res = (u >> 1) ^ -(u & 1)  # un-zigzag
+
+    # residual is the order-th difference: integrate back up, seeding each
+    # level with the last value of that difference of the warm-up samples
+    seq = res
+    for j in reversed(range(order)):
+        seed = np.diff(warm, n=j)[-1]
+        seq = seed + np.cumsum(seq)
+    out = np.empty(n, dtype=np.int64)
+    out[:order] = warm
+    out[order:] = seq
+    return out.astype(np.int16), length
+
+def spectrum_band_edges(fft_size: int, bands: int) -> list[int]:
+    """FFT bin edges of the log bands, same rounding as spectrum_init()."""
+    half = fft_size // 2
+    if bands == 0:
+        return list(range(half + 1))
+    edges = [1]
+    for k in range(1, bands):
+        e = int(math.pow(half, k / bands) + 0.5)
+        edges.append(e if e > edges[-1] else edges[-1] + 1)
+    edges.append(half)
+    return edges
+
+
+@dataclass
+class LinkCounters:
+    """Framing health since connect(); every resync is one of the *_errors."""
+    frames: int = 0          # good frames (footer matched)
+    wire_bytes: int = 0      # bytes of good frames, header to footer
+    skipped_bytes: int = 0   # bytes thrown away while hunting for FRAME_HDR
+    type_errors: int = 0     # header followed by an unknown type
+    length_errors: int = 0   # L > MAX_L, or L disagrees with the COBS frame size
+    footer_errors: int = 0
+    crc_errors: int = 0      # cobs: bad CRC or malformed COBS
+    decode_errors: int = 0   # good frame, value did not decode (not a resync)
+
+    @property
+    def resyncs(self) -> int:
+        return self.type_errors + self.length_errors + self.footer_errors + self.crc_errors
+
 
 @dataclass
 class SerialConfig:
     baud: int
-    sample_rate_hz: int  # used for metadata only (device doesn't need it)
+    sample_rate_hz: int  # until the device reports its own (TLV_STREAM_CFG_ACK)
+    framing: str = "magic"
+    channels: int = 1
 
 class SerialTLVSource(AudioSource):
     def __init__(
         self,
         on_rx_tlv: Optional[Callable[[int, int], None]] = None,
         log_cb: Optional[Callable[[str, str], None]] = None,
+        stats_cb: Optional[Callable[[dict], None]] = None,
+        latency_cb: Optional[Callable[[dict], None]] = None,
+        stream_cfg_cb: Optional[Callable[[dict], None]] = None,
+        spectrum_cb: Optional[Callable[[list[SpectrumFrame]], None]] = None,
+        mfcc_cb: Optional[Callable[[list[MfccFrame]], None]] = None,
+        half_rate_cb: Optional[Callable[[AudioFrame], None]] = None,
     ) -> None:
         self._ser: Optional[serial.Serial] = None
         self._cfg: Optional[SerialConfig] = None
@@ -39,6 +309,25 @@ class SerialTLVSource(AudioSource):
 
         self._on_rx_tlv = on_rx_tlv
         self._log_cb = log_cb
+        self._stats_cb = stats_cb
+        self._latency_cb = latency_cb
+        self._stream_cfg_cb = stream_cfg_cb
+        self._spectrum_cb = spectrum_cb
+        self._mfcc_cb = mfcc_cb
+        self._half_rate_cb = half_rate_cb
+        # device replies (TLV type -> (count, last value)), for request/response
+        self._reply_cv = threading.Condition()
+        self._replies: dict[int, tuple[int, dict]] = {}
+        self._burst: dict[int, bool] = {}  # TLV_LINK_TEST seq -> pattern ok
+        self._burst_count = 0
+        self._boot_baud = 0
+        self._keepalive: Optional[threading.Thread] = None
+        self._dropped = 0
+        self._link = LinkCounters()
+        self._rx_ns: Optional[int] = None
+        self._wire_bytes = 0
+        self._clip_start = False  # TLV_TRIGGER_EVENT seen, marks the next frame
+        self._tx_lock = threading.Lock()
 
     def list_endpoints(self) -> list[dict]:
         out = []
@@ -57,9 +346,13 @@ class SerialTLVSource(AudioSource):
     def connect(self, endpoint: str, **kwargs) -> None:
         baud = int(kwargs.get("baud", 921600))
         sr = int(kwargs.get("sample_rate_hz", 16000))
+        framing = str(kwargs.get("framing", "magic"))
+        if framing not in FRAMINGS:
+            raise ValueError(f"framing must be one of {FRAMINGS}")
         self.disconnect()
 
-        self._cfg = SerialConfig(baud=baud, sample_rate_hz=sr)
+        self._cfg = SerialConfig(baud=baud, sample_rate_hz=sr, framing=framing)
+        self._boot_baud = baud
         self._ser = serial.Serial(endpoint, baudrate=baud, timeout=0.2)
         time.sleep(0.2)
         try:
@@ -71,6 +364,9 @@ class SerialTLVSource(AudioSource):
         self._thread = threading.Thread(target=self._reader_loop, daemon=True)
         self._thread.start()
 
+        # learn the device's stream format; firmware without RX just ignores it
+        self.send_tlv(TLV_STREAM_CFG)
+
     def disconnect(self) -> None:
         self._stop.set()
         if self._ser is not None:
@@ -81,6 +377,8 @@ class SerialTLVSource(AudioSource):
         self._ser = None
         self._cfg = None
         self._last_ts = None
+        self._dropped = 0
+        self._link = LinkCounters()
         # drain queue
         while True:
             try:
@@ -91,118 +389,560 @@ class SerialTLVSource(AudioSource):
     def is_connected(self) -> bool:
         return self._ser is not None and self._ser.is_open
 
-    def frames(self) -> Iterable[AudioFrame]:
+    def dropped_frames(self) -> int:
+        return self._dropped
+
+    def link_counters(self) -> LinkCounters:
+        return LinkCounters(**self._link.__dict__)
+
+    def send_tlv(self, t: int, v: bytes = b"") -> None:
+        """Writes one framed host -> device TLV."""
+        ser = self._ser
+        if ser is None:
+            raise RuntimeError("not connected")
+        frame = frame_tlv(t, v, self._cfg.framing if self._cfg else "magic")
+        with self._tx_lock:
+            ser.write(frame)
+
+    def request_latency_dump(self, reset: bool = False) -> None:
+        """Device answers with one TLV_LAT_HIST per stage."""
+        self.send_tlv(TLV_LAT_DUMP, bytes([1 if reset else 0]))
+
+    def set_noise_suppression(self, on: bool) -> None:
+        """Switches the device noise suppressor (firmware CONFIG_PDM_NS); no reply."""
+        self.send_tlv(TLV_NS_CTRL, bytes([1 if on else 0]))
+
+    def trigger(self, fire: bool = True) -> None:
+        """Triggered capture (CONFIG_PDM_TRIGGER): start a clip now, or re-arm."""
+        self.send_tlv(TLV_TRIGGER_CTRL, bytes([1 if fire else 0]))
+
+    def configure_stream(self, sample_rate_hz: int = 0, block_ms: int = 0, channels: int = 0,
+                         pcm_width_bits: int = 0, timeout: float = 5.0) -> dict:
         """
-        Yields frames as they arrive. This blocks until frames are available.
+        Restarts the device stream with the given format (0 = keep) and
+        returns its TLV_STREAM_CFG_ACK; status is 0 or a negative errno and
+        the other fields are what the device runs with now. All zeros just
+        queries. Raises TimeoutError if no ACK arrives.
         """
-        while self.is_connected():
-            try:
-                yield self._q.get(timeout=0.5)
-            except Empty:
-                continue
+        seq = self._reply_seq(TLV_STREAM_CFG_ACK)
+        self.send_tlv(TLV_STREAM_CFG, STREAM_CFG.pack(sample_rate_hz, block_ms, channels, pcm_width_bits))
+        return self._wait_reply(TLV_STREAM_CFG_ACK, seq, timeout)
 
-    def _read_exact(self, n: int) -> bytes:
-        assert self._ser is not None
-        buf = bytearray()
-        while len(buf) < n and not self._stop.is_set():
-            chunk = self._ser.read(n - len(buf))
-            if chunk:
-                buf.extend(chunk)
-        return bytes(buf)
+    def baud(self) -> int:
+        return self._cfg.baud if self._cfg else 0
 
-    def _reader_loop(self) -> None:
-        assert self._ser is not None
+    def negotiate_baud(self, rates: Iterable[int]) -> int:
+        """
+        Offers the device each rate in turn (fastest first) and returns the
+        rate the link ends up on. A rate sticks only if the device's test
+        burst arrives intact and our confirm, sent at that rate, is acked;
+        otherwise both sides fall back and the next rate is tried.
+        """
+        ser = self._ser
+        if ser is None or self._cfg is None:
+            raise RuntimeError("not connected")
+        base = self._cfg.baud
 
-        ALLOWED_TYPES = {TLV_TS, TLV_PCM, 0x7F}  # TS, PCM, SYNC (optional)
+        for rate in rates:
+            if rate == base:
+                break
+            seq = self._reply_seq(TLV_LINK_RATE_ACK)
+            with self._reply_cv:
+                self._burst = {}
+                self._burst_count = 0
+            self.send_tlv(TLV_LINK_RATE, struct.pack("<I", rate))
+            try:
+                ack = self._wait_reply(TLV_LINK_RATE_ACK, seq, 1.0)
+            except TimeoutError:
+                self._log(f"No link rate ACK at {base}: device without CONFIG_PDM_LINK_RATE?", "warn")
+                return base
+            if ack["status"] != 0 or ack["baud"] != rate:
+                self._log(f"Device refused {rate} baud ({ack['status']})", "warn")
+                continue
 
-        # sliding 4-byte window to find header
-        win = bytearray()
+            ser.baudrate = rate
+            with self._reply_cv:
+                self._reply_cv.wait_for(
+                    lambda: self._burst_count and len(self._burst) == self._burst_count, timeout=1.0)
+                burst_ok = bool(self._burst_count) and len(self._burst) == self._burst_count \
+                    and all(self._burst.values())
+                got = sum(self._burst.values())
+
+            if burst_ok:
+                seq = self._reply_seq(TLV_LINK_RATE_ACK)
+                self.send_tlv(TLV_LINK_CONFIRM, b"\x01")
+                try:
+                    ack = self._wait_reply(TLV_LINK_RATE_ACK, seq, LINK_CONFIRM_S)
+                except TimeoutError:
+                    ack = None
+                if ack is not None and ack["status"] == 0 and ack["baud"] == rate:
+                    self._cfg.baud = rate
+                    if self._keepalive is None or not self._keepalive.is_alive():
+                        self._keepalive = threading.Thread(target=self._keepalive_loop, daemon=True)
+                        self._keepalive.start()
+                    self._log(f"Link now at {rate} baud", "ok")
+                    return rate
+            self._log(f"{rate} baud failed ({got} of {self._burst_count or '?'} test frames good)", "warn")
+
+            # the device reverts on its own after CONFIG_PDM_LINK_RATE_CONFIRM_MS
+            seq = self._reply_seq(TLV_LINK_RATE_ACK)
+            ser.baudrate = base
+            try:
+                self._wait_reply(TLV_LINK_RATE_ACK, seq, LINK_CONFIRM_S)
+            except TimeoutError:
+                pass
+        return base
+
+    def _keepalive_loop(self) -> None:
+        """At a negotiated rate the device falls back if we go quiet."""
+        while not self._stop.wait(LINK_KEEPALIVE_S):
+            cfg = self._cfg
+            if cfg is None or cfg.baud == self._boot_baud:
+                return
+            try:
+                self.send_tlv(TLV_LINK_RATE, struct.pack("<I", 0))
+            except (RuntimeError, serial.SerialException, OSError):
+                return
+
+    def _log(self, msg: str, level: str) -> None:
+        if self._log_cb:
+            self._log_cb(msg, level)
+
+    def _reply_seq(self, t: int) -> int:
+        with self._reply_cv:
+            return self._replies.get(t, (0, {}))[0]
+
+    def _wait_reply(self, t: int, seq: int, timeout: float) -> dict:
+        """First reply of type t after _reply_seq(t) returned seq."""
+        with self._reply_cv:
+            if not self._reply_cv.wait_for(lambda: self._replies.get(t, (0, {}))[0] != seq, timeout=timeout):
+                raise TimeoutError(f"no reply 0x{t:02X} from device")
+            return dict(self._replies[t][1])
+
+    def _post_reply(self, t: int, value: dict) -> None:
+        with self._reply_cv:
+            n = self._replies.get(t, (0, {}))[0]
+            self._replies[t] = (n + 1, value)
+            self._reply_cv.notify_all()
 
-        def read_u32_le(b: bytes) -> int:
-            return int.from_bytes(b, "little")
+    def frames(self) -> Iterable[AudioFrame]:
+        """
+        Yields frames as they arrive. This blocks until frames are available.
+        """
+        while self.is_connected():
+            frame = self.get_frame(timeout=0.5)
+            if frame is not None:
+                yield frame
 
-        while not self._stop.is_set():
+    def get_frame(self, timeout: float) -> Optional[AudioFrame]:
+        """Next decoded frame, or None if nothing arrived within timeout."""
+        try:
+            return self._q.get(timeout=timeout)
+        except Empty:
+            return None
+
+    def _queue_pcm(self, timestamp_ms: Optional[int], samples: np.ndarray,
+                   sample_index: Optional[int] = None, silent_samples: int = 0,
+                   noise_floor_rms: int = 0) -> None:
+        cfg = self._cfg
+        frame = AudioFrame(timestamp_ms=timestamp_ms, samples_i16=samples,
+                           sample_index=sample_index,
+                           rx_ns=self._rx_ns, queued_ns=time.monotonic_ns(),
+                           wire_bytes=self._wire_bytes,
+                           sample_rate_hz=cfg.sample_rate_hz if cfg else None,
+                           channels=cfg.channels if cfg else 1,
+                           silent_samples=silent_samples, noise_floor_rms=noise_floor_rms,
+                           clip_start=self._clip_start)
+        try:
+            self._q.put_nowait(frame)
+            self._clip_start = False
+            if self._log_cb:
+                self._log_cb(f"Queued PCM frame: {len(samples) or silent_samples} samples "
+                             f"{'(silence) ' if silent_samples else ''}ts={timestamp_ms}", "ok")
+        except Exception:
+            self._dropped += 1
+
+    def _process_tlv(self, t: int, L: int, v: bytes) -> None:
+        if t == TLV_TS and L == 4:
+            (self._last_ts,) = struct.unpack("<I", v)
+
+        elif t == TLV_PCM:
+            if L % 2 != 0:
+                return
+            self._queue_pcm(self._last_ts, np.frombuffer(v, dtype="<i2"))
+
+        elif t == TLV_BATCH:
+            if L < BATCH_HDR.size:
+                return
+            first_ts, n_blocks, spb, first_idx = BATCH_HDR.unpack_from(v)
+            pcm = v[BATCH_HDR.size:]
+            channels = self._cfg.channels if self._cfg else 1
+            if len(pcm) != n_blocks * spb * 2 * channels:
+                if self._log_cb:
+                    self._log_cb(f"Bad PCM batch: {n_blocks}x{spb} vs {len(pcm)} bytes", "warn")
+                return
+            # one frame per batch: the blocks are contiguous samples, viewed in place
+            self._last_ts = first_ts
+            self._queue_pcm(first_ts, np.frombuffer(pcm, dtype="<i2"), first_idx)
+
+        elif t == TLV_ADPCM:
+            if L < BATCH_HDR.size:
+                return
+            first_ts, n_blocks, spb, first_idx = BATCH_HDR.unpack_from(v)
+            blk = ima_block_bytes(spb)
+            if spb == 0 or L != BATCH_HDR.size + n_blocks * blk:
+                if self._log_cb:
+                    self._log_cb(f"Bad ADPCM batch: {n_blocks}x{spb} vs {L} bytes", "warn")
+                return
+            off = BATCH_HDR.size
+            pcm = np.concatenate([
+                ima_adpcm_decode_block(v[off + i * blk: off + (i + 1) * blk], spb)
+                for i in range(n_blocks)
+            ])
+            self._last_ts = first_ts
+            self._queue_pcm(first_ts, pcm, first_idx)
+
+        elif t == TLV_LOSSLESS:
+            if L < BATCH_HDR.size:
+                return
+            first_ts, n_blocks, spb, first_idx = BATCH_HDR.unpack_from(v)
+            off = BATCH_HDR.size
+            blocks = []
             try:
-                # ---- 1) Find header 0xAA55AA55 ----
-                while not self._stop.is_set():
-                    b = self._ser.read(1)
-                    if not b:
-                        continue
-                    win += b
-                    if len(win) > 4:
-                        del win[0]
-                    if len(win) == 4 and read_u32_le(win) == FRAME_HDR:
+                for _ in range(n_blocks):
+                    samples, used = fixed_rice_decode_block(v[off:], spb)
+                    blocks.append(samples)
+                    off += used
+            except (ValueError, struct.error) as e:
+                if self._log_cb:
+                    self._log_cb(f"Bad lossless batch: {e}", "warn")
+                return
+            self._last_ts = first_ts
+            self._queue_pcm(first_ts, np.concatenate(blocks), first_idx)
+
+        elif t == TLV_PCM_HALF:
+            if L < BATCH_HDR.size:
+                return
+            first_ts, n_blocks, spb, first_idx = BATCH_HDR.unpack_from(v)
+            pcm = v[BATCH_HDR.size:]
+            channels = self._cfg.channels if self._cfg else 1
+            if len(pcm) != n_blocks * spb * 2 * channels:
+                if self._log_cb:
+                    self._log_cb(f"Bad half-rate batch: {n_blocks}x{spb} vs {len(pcm)} bytes", "warn")
+                return
+            sr = self._cfg.sample_rate_hz if self._cfg else None
+            if self._half_rate_cb:
+                self._half_rate_cb(AudioFrame(
+                    timestamp_ms=first_ts, samples_i16=np.frombuffer(pcm, dtype="<i2"),
+                    sample_index=first_idx, rx_ns=self._rx_ns, wire_bytes=self._wire_bytes,
+                    sample_rate_hz=sr // 2 if sr else None, channels=channels))
+
+        elif t == TLV_SILENCE:
+            if L < BATCH_HDR.size + SILENCE_FLOOR.size:
+                return
+            first_ts, n_blocks, spb, first_idx = BATCH_HDR.unpack_from(v)
+            (floor,) = SILENCE_FLOOR.unpack_from(v, BATCH_HDR.size)
+            # no samples: the hub fills n_blocks * spb in at the noise floor
+            self._last_ts = first_ts
+            self._queue_pcm(first_ts, np.empty(0, dtype=np.int16), first_idx,
+                            silent_samples=n_blocks * spb, noise_floor_rms=floor)
+
+        elif t == TLV_TRIGGER_EVENT:
+            if L < TRIGGER_EVENT.size:
+                return
+            srcs, _, preroll, first_idx = TRIGGER_EVENT.unpack_from(v)
+            # the blocks ahead of the clip were never sent: not a loss
+            self._clip_start = True
+            if self._log_cb:
+                names = ",".join(n for i, n in enumerate(TRIGGER_SRCS) if srcs & (1 << i)) or "?"
+                self._log_cb(f"Trigger ({names}): clip from sample {first_idx}, {preroll} pre-roll blocks", "ok")
+
+        elif t == TLV_SPECTRUM:
+            if L < BATCH_HDR.size:
+                return
+            first_ts, n_blocks, spb, first_idx = BATCH_HDR.unpack_from(v)
+            off = BATCH_HDR.size
+            sr = self._cfg.sample_rate_hz if self._cfg else None
+            frames = []
+            for i in range(n_blocks):
+                if off + SPECTRUM_HDR.size > L:
+                    break
+                nbins, log2n, flags = SPECTRUM_HDR.unpack_from(v, off)
+                off += SPECTRUM_HDR.size
+                if off + nbins > L:
+                    break
+                frames.append(SpectrumFrame(
+                    timestamp_ms=first_ts + (i * spb * 1000 // sr if sr else 0),
+                    sample_index=first_idx + i * spb, block_samples=spb,
+                    fft_size=1 << log2n, banded=bool(flags & SPECTRUM_FLAG_BANDS),
+                    levels=bytes(v[off:off + nbins]), sample_rate_hz=sr))
+                off += nbins
+            if len(frames) != n_blocks or off != L:
+                if self._log_cb:
+                    self._log_cb(f"Bad spectrum batch: {n_blocks} frames vs {L} bytes", "warn")
+                return
+            self._last_ts = first_ts
+            if self._spectrum_cb:
+                self._spectrum_cb(frames)
+
+        elif t == TLV_MFCC:
+            if L < BATCH_HDR.size:
+                return
+            first_ts, n_blocks, spb, first_idx = BATCH_HDR.unpack_from(v)
+            off = BATCH_HDR.size
+            sr = self._cfg.sample_rate_hz if self._cfg else None
+            vecs = []
+            try:
+                for b in range(n_blocks):
+                    count, ncoef, hop, first_end = MFCC_HDR.unpack_from(v, off)
+                    off += MFCC_HDR.size
+                    coefs = np.frombuffer(v, dtype="<i2", count=count * ncoef, offset=off)
+                    off += coefs.nbytes
+                    for i in range(count):
+                        end = b * spb + first_end + i * hop  # frame end, samples into the batch
+                        vecs.append(MfccFrame(
+                            timestamp_ms=first_ts + (end * 1000 // sr if sr else 0),
+                            sample_index=first_idx + end, hop=hop,
+                            coefs=(coefs[i * ncoef:(i + 1) * ncoef] * MFCC_COEF_SCALE).tolist()))
+            except (ValueError, struct.error):
+                off = -1
+            if off != L:
+                if self._log_cb:
+                    self._log_cb(f"Bad MFCC batch: {n_blocks} blocks vs {L} bytes", "warn")
+                return
+            self._last_ts = first_ts
+            if self._mfcc_cb:
+                self._mfcc_cb(vecs)
+
+        elif t == TLV_STATS:
+            if L >= STATS_FMT.size and self._stats_cb:
+                stats = dict(zip(STATS_FIELDS, STATS_FMT.unpack_from(v)))
+                off = STATS_FMT.size
+                for fmt, fields in STATS_EXT:
+                    if L < off + fmt.size:
                         break
+                    stats.update(zip(fields, fmt.unpack_from(v, off)))
+                    off += fmt.size
+                self._stats_cb(stats)
+
+        elif t == TLV_STREAM_CFG_ACK:
+            if L < STREAM_ACK.size:
+                return
+            ack = dict(zip(STREAM_ACK_FIELDS, STREAM_ACK.unpack_from(v)))
+            if ack["status"] != 0:
+                ack["error"] = os.strerror(-ack["status"])
+            if self._cfg is not None:
+                self._cfg.sample_rate_hz = ack["sample_rate_hz"]
+                self._cfg.channels = ack["channels"]
+            self._post_reply(t, ack)
+            if self._stream_cfg_cb:
+                self._stream_cfg_cb(ack)
+            if self._log_cb:
+                self._log_cb(f"Stream config: {ack['sample_rate_hz']} Hz, {ack['block_ms']} ms, "
+                             f"{ack['channels']}ch (status {ack['status']})",
+                             "ok" if ack["status"] == 0 else "warn")
+
+        elif t == TLV_LINK_RATE_ACK:
+            if L >= LINK_ACK.size:
+                self._post_reply(t, dict(zip(("status", "baud", "boot_baud"), LINK_ACK.unpack_from(v))))
+
+        elif t == TLV_LINK_TEST:
+            if L < LINK_TEST_HDR.size or (L - LINK_TEST_HDR.size) % 2:
+                return
+            seq, count, _, first = LINK_TEST_HDR.unpack_from(v)
+            got = np.frombuffer(v, dtype="<i2", offset=LINK_TEST_HDR.size)
+            with self._reply_cv:
+                self._burst[seq] = bool(np.array_equal(got, pattern_hash(first, got.size)))
+                self._burst_count = count
+                self._reply_cv.notify_all()
+
+        elif t == TLV_LAT_HIST:
+            if L < LAT_HDR.size:
+                return
+            stage, nb, _, count, max_us, sum_us = LAT_HDR.unpack_from(v)
+            if L < LAT_HDR.size + 4 * nb or self._latency_cb is None:
+                return
+            buckets = list(struct.unpack_from(f"<{nb}I", v, LAT_HDR.size))
+            self._latency_cb({
+                "stage": DEVICE_STAGES[stage] if stage < len(DEVICE_STAGES) else str(stage),
+                "count": count,
+                "mean_us": sum_us // count if count else None,
+                "p50_us": percentile_us(buckets, 0.50),
+                "p99_us": percentile_us(buckets, 0.99),
+                "max_us": max_us,
+                "buckets": buckets,
+            })
 
-                if self._stop.is_set():
-                    break
+    def _decode_tlv(self, t: int, L: int, v: bytes) -> bool:
+        """_process_tlv; a value that doesn't decode costs only its frame."""
+        try:
+            self._process_tlv(t, L, v)
+        except (ValueError, struct.error) as e:
+            self._link.decode_errors += 1
+            if self._log_cb:
+                self._log_cb(f"Bad TLV value T=0x{t:02X} L={L}: {e}, dropped", "warn")
+            return False
+        return True
 
-                # ---- 2) Read TLV header: T(1) + L(2 LE) ----
-                t_b = self._read_exact(1)
-                if len(t_b) != 1:
-                    continue
-                t = t_b[0]
+    def _reader_loop(self) -> None:
+        if self._cfg is not None and self._cfg.framing == "cobs":
+            self._reader_loop_cobs()
+        else:
+            self._reader_loop_magic()
 
-                l_bytes = self._read_exact(2)
-                if len(l_bytes) != 2:
-                    continue
-                (L,) = struct.unpack("<H", l_bytes)
+    def _reader_loop_cobs(self) -> None:
+        """
+        Resync is buf.find(0): a corrupt frame costs exactly that frame.
+        The bytes before the first 0x00 after connect are a partial frame.
+        """
+        assert self._ser is not None
+        buf = bytearray()
+        synced = False
 
-                # Reject false header hits early
-                if t not in ALLOWED_TYPES:
-                    if self._log_cb:
-                        self._log_cb(f"Unknown TLV type 0x{t:02X} after header; resync", "warn")
-                    win.clear()
+        while not self._stop.is_set():
+            try:
+                chunk = self._ser.read(max(1, self._ser.in_waiting))
+                if not chunk:
                     continue
+                buf += chunk
 
-                if L > MAX_L:
-                    if self._log_cb:
-                        self._log_cb(f"Bad TLV length {L}, resyncing...", "warn")
-                    win.clear()
-                    continue
+                start = 0
+                while True:
+                    end = buf.find(0, start)
+                    if end < 0:
+                        break
+                    enc = bytes(buf[start:end])
+                    start = end + 1
+                    if not synced:
+                        synced = True
+                        self._link.skipped_bytes += len(enc) + 1
+                        continue
+                    if not enc:
+                        continue
+                    self._handle_cobs_frame(enc)
+                del buf[:start]
+
+                if len(buf) > COBS_MAX_ENC:
+                    # no delimiter where one must have been: drop and wait for the next
+                    self._link.skipped_bytes += len(buf)
+                    self._link.length_errors += 1
+                    buf.clear()
+            except (serial.SerialException, OSError):
+                break
+            except Exception as e:
+                if self._log_cb:
+                    self._log_cb(f"Reader error: {e!r}, resyncing", "bad")
+                buf.clear()
+                continue
 
-                # ---- 3) Read value ----
-                v = self._read_exact(L) if L else b""
-                if len(v) != L:
-                    win.clear()
-                    continue
+    def _handle_cobs_frame(self, enc: bytes) -> None:
+        try:
+            raw = cobs_decode(enc)
+        except ValueError:
+            raw = b""
+        if len(raw) < COBS_TL.size + 4 or zlib.crc32(raw[:-4]) != int.from_bytes(raw[-4:], "little"):
+            self._link.crc_errors += 1
+            self._link.skipped_bytes += len(enc) + 1
+            if self._log_cb:
+                self._log_cb(f"CRC mismatch on {len(enc)} byte frame, dropped", "warn")
+            return
+        t, L = COBS_TL.unpack_from(raw)
+        if L != len(raw) - COBS_TL.size - 4:
+            self._link.length_errors += 1
+            return
+
+        self._rx_ns = time.monotonic_ns()
+        self._wire_bytes = len(enc) + 1
+        self._link.frames += 1
+        self._link.wire_bytes += self._wire_bytes
+        if not self._decode_tlv(t, L, raw[COBS_TL.size:-4]):
+            return
+        if self._log_cb:
+            self._log_cb(f"RX COBS TLV: T=0x{t:02X} L={L}", "dim")
+
+    def _reader_loop_magic(self) -> None:
+        """
+        Reads whatever the port holds in one call (or the rest of a frame
+        it is waiting for) and parses every frame in it; see _parse_magic.
+        Each read is a new bytes object, so the memoryview values handed to
+        _process_tlv, and anything built on them, stay valid after the loop
+        moves on. Only a partial frame is carried over into the next read.
+        """
+        assert self._ser is not None
+        buf = b""
+        need = 0
 
-                # ---- 4) Read footer EXACTLY 4 bytes ----
-                ftr = self._read_exact(4)
-                if len(ftr) != 4 or read_u32_le(ftr) != FRAME_FTR:
-                    if self._log_cb:
-                        got = read_u32_le(ftr) if len(ftr) == 4 else None
-                        self._log_cb(f"Footer mismatch (got={got}), resyncing...", "warn")
-                    win.clear()
+        while not self._stop.is_set():
+            try:
+                # at least a minimal frame: no read returns a lone byte of a header
+                chunk = self._ser.read(max(MAGIC_MIN_FRAME, need, self._ser.in_waiting))
+                if not chunk:
                     continue
+                buf = buf + chunk if buf else chunk
+                used, need = self._parse_magic(buf)
+                buf = buf[used:]
+            except (serial.SerialException, OSError):
+                break
+            except Exception as e:
+                if self._log_cb:
+                    self._log_cb(f"Reader error: {e!r}, resyncing", "bad")
+                buf, need = b"", 0
+                continue
 
-                # ---- 5) Process TLV ----
-                if t == TLV_TS and L == 4:
-                    (self._last_ts,) = struct.unpack("<I", v)
-
-                elif t == TLV_PCM:
-                    if L % 2 != 0:
-                        continue
-                    samples = struct.unpack("<" + "h" * (L // 2), v)
-                    frame = AudioFrame(timestamp_ms=self._last_ts, samples_i16=list(samples))
-                    try:
-                        self._q.put_nowait(frame)
-                        if self._log_cb:
-                            self._log_cb(f"Queued PCM frame: {len(samples)} samples ts={self._last_ts}", "ok")
-                    except Exception:
-                        pass
-
-                # ---- 6) Log (optional) ----
+    def _parse_magic(self, buf: bytes) -> tuple[int, int]:
+        """
+        Frames in buf, found with bytes.find and processed in place.
+        Returns (bytes consumed, bytes still missing from the frame at
+        buf[consumed:], 0 if none started). A rejected header resyncs from
+        the byte after it, so a false FRAME_HDR hit costs no real frame.
+        """
+        mv = memoryview(buf)
+        n = len(buf)
+        pos = 0
+        while True:
+            h = buf.find(MAGIC_HDR, pos)
+            if h < 0:
+                keep = max(pos, n - len(MAGIC_HDR) + 1)  # a header may straddle reads
+                self._link.skipped_bytes += keep - pos
+                return keep, 0
+            self._link.skipped_bytes += h - pos
+            if n - h < MAGIC_HDR_TL:
+                return h, MAGIC_HDR_TL - (n - h)
+
+            t, L = MAGIC_TL.unpack_from(buf, h + len(MAGIC_HDR))
+            if t not in MAGIC_TYPES:
+                self._link.type_errors += 1
                 if self._log_cb:
-                    hdr_hex = " ".join(f"{b:02X}" for b in (bytes([t]) + l_bytes))
-                    self._log_cb(f"RX FRAMED TLV: T=0x{t:02X} L={L} hdr=[{hdr_hex}]", "dim")
+                    self._log_cb(f"Unknown TLV type 0x{t:02X} after header; resync", "warn")
+                pos = h + 1
+                continue
+            if L > MAX_L:
+                self._link.length_errors += 1
+                if self._log_cb:
+                    self._log_cb(f"Bad TLV length {L}, resyncing...", "warn")
+                pos = h + 1
+                continue
 
-                win.clear()  # clean slate after a good frame
+            end = h + MAGIC_HDR_TL + L + len(MAGIC_FTR)
+            if end > n:
+                return h, end - n
+            if buf[end - len(MAGIC_FTR):end] != MAGIC_FTR:
+                self._link.footer_errors += 1
+                if self._log_cb:
+                    got = int.from_bytes(buf[end - len(MAGIC_FTR):end], "little")
+                    self._log_cb(f"Footer mismatch (got={got}), resyncing...", "warn")
+                pos = h + 1
+                continue
 
-            except (serial.SerialException, OSError):
-                break
-            except Exception:
-                win.clear()
+            self._rx_ns = time.monotonic_ns()
+            self._wire_bytes = end - h
+            self._link.frames += 1
+            self._link.wire_bytes += self._wire_bytes
+            pos = end
+            if not self._decode_tlv(t, L, mv[h + MAGIC_HDR_TL:end - len(MAGIC_FTR)]):
                 continue
+            if self._log_cb:
+                hdr_hex = " ".join(f"{b:02X}" for b in buf[h + len(MAGIC_HDR):h + MAGIC_HDR_TL])
+                self._log_cb(f"RX FRAMED TLV: T=0x{t:02X} L={L} hdr=[{hdr_hex}]", "dim")
 
 
@@ -1,12 +1,16 @@
 from __future__ import annotations
 import threading
-from dataclasses import dataclass
-from typing import Optional
+import time
+from dataclasses import dataclass, replace
+from typing import Callable, Optional
 from collections import deque
 
-from .sources.base import AudioSource, AudioFrame
+import numpy as np
+
+from .sources.base import AudioSource, AudioFrame, SpectrumFrame, MfccFrame
 from .recorder import CSVRecorder
-from collections import deque
+from .latency import LatencyTracker
+from .ring import SampleRing
 
 
 @dataclass
@@ -16,14 +20,51 @@ class StreamStatus:
     baud: Optional[int] = None
     sample_rate_hz: int = 16000
     last_timestamp_ms: Optional[int] = None
-    dropped_frames: int = 0
+    dropped_frames: int = 0             # host side: source queue overflow
+    device_stats: Optional[dict] = None # last TLV_T_STATS from the firmware
+    lost_samples: int = 0               # from jumps in the device sample index
+    gaps: int = 0
+    silent_samples: int = 0             # VAD gated on the device, filled in here
+    spectra: int = 0                    # device spectrum frames (PDM_CODEC_SPECTRUM)
+    mfcc_vectors: int = 0               # device MFCC vectors (PDM_CODEC_MFCC)
+    half_rate_samples: int = 0          # device half-rate copy (PDM_DECIM_HALF_RATE)
+    clips: int = 0                      # triggered clips started (PDM_TRIGGER)
+    channels: int = 1
+    stream_config: Optional[dict] = None  # last TLV_T_STREAM_CFG_ACK from the firmware
 
 class StreamHub:
     """
     One source -> ring buffer for UI + optional recorder.
     Future BLE can plug in via AudioSource.
+
+    Frames that carry a device sample index are checked for gaps; missing
+    samples are concealed (linear interpolation or silence) before the ring
+    and the recorder see them, so the recorded timeline stays sample-exact.
+
+    Silence runs the device VAD did not send (AudioFrame.silent_samples)
+    are filled in with noise at the reported noise floor, or zeros, so the
+    ring and the recorder see a continuous timeline.
+
+    When frames arrive in a new stream format (the device was reconfigured)
+    the ring is resized and a running recording continues in a new file.
+    The ring holds channel 0 only. Samples stay int16 arrays from the
+    source to the ring and the recorder, nothing is boxed per sample.
+
+    The pump thread is the ring's only writer and never takes the hub lock
+    for it (disconnect() joins it, so a reconnect never has two); readers (ring_snapshot, ring_read) copy out without the lock
+    either, see SampleRing. A ring replaced on a format change or a new
+    connection carries the cursor on, so readers can follow it across.
+    Data listeners are called from the pump thread after every frame
+    that reached the ring (websocket push, see main.py).
+
+    Device spectra and MFCC vectors (devices built with those codecs send
+    them instead of audio) go to their own bounded histories, and so does
+    the half-rate copy of the stream (channel 0, no concealment).
     """
-    def __init__(self, wave_seconds: float, default_sr: int, recorder: CSVRecorder):
+    def __init__(self, wave_seconds: float, default_sr: int, recorder: CSVRecorder,
+                 conceal: str = "interp", max_conceal_seconds: float = 5.0,
+                 silence_fill: str = "noise", spectrogram_frames: int = 500,
+                 mfcc_frames: int = 1000):
         self._lock = threading.Lock()
         self._status = StreamStatus(sample_rate_hz=default_sr)
         self._source: Optional[AudioSource] = None
@@ -31,33 +72,150 @@ class StreamHub:
         self._stop = threading.Event()
 
         self._wave_seconds = wave_seconds
-        self._ring = deque(maxlen=int(default_sr * wave_seconds))  # int16 samples for UI
+        self._ring = SampleRing(int(default_sr * wave_seconds))  # channel 0 for the UI
         self._recorder = recorder
         self._logs = deque(maxlen=300)
+        self.latency = LatencyTracker()
+        self._last_rx_ns: Optional[int] = None
+        # ring cursor, timestamp_ms and sample rate of the newest timestamped frame's first sample
+        self._ts_anchor: Optional[tuple[int, int, int]] = None
+
+        self._conceal = conceal
+        self._max_conceal_seconds = max_conceal_seconds
+        self._next_index: Optional[int] = None  # pump thread only
+        self._last_sample = 0
+        self._silence_fill = silence_fill
+        self._rng = np.random.default_rng()
+        self._spectra: deque[SpectrumFrame] = deque(maxlen=spectrogram_frames)
+        self._mfcc: deque[MfccFrame] = deque(maxlen=mfcc_frames)
+        self._half = SampleRing(int(default_sr // 2 * wave_seconds))
+        self._half_sr: Optional[int] = None
+        self._half_next: Optional[int] = None  # sample index after the newest in _half
+        self._listeners: tuple[Callable[[], None], ...] = ()
 
     def status(self) -> StreamStatus:
         with self._lock:
+            if self._source is not None and self._status.connected:
+                self._status.dropped_frames = self._source.dropped_frames()
             return StreamStatus(**self._status.__dict__)
 
-    def ring_snapshot(self, max_samples: int) -> list[int]:
+    def set_device_stats(self, stats: dict) -> None:
+        with self._lock:
+            self._status.device_stats = stats
+
+    def set_baud(self, baud: int) -> None:
+        """Link rate changed under a running stream (baud negotiation)."""
+        with self._lock:
+            self._status.baud = baud
+
+    def set_stream_config(self, ack: dict) -> None:
         with self._lock:
-            if max_samples <= 0:
+            self._status.stream_config = ack
+
+    def last_rx_ns(self) -> Optional[int]:
+        """Wire arrival (monotonic_ns) of the newest samples in the ring."""
+        with self._lock:
+            return self._last_rx_ns
+
+    def add_spectra(self, frames: list[SpectrumFrame]) -> None:
+        """Source thread: one decoded TLV_SPECTRUM batch."""
+        if not frames:
+            return
+        with self._lock:
+            if self._spectra and len(self._spectra[-1].levels) != len(frames[0].levels):
+                self._spectra.clear()  # device rebuilt with another band layout
+            self._spectra.extend(frames)
+            self._status.spectra += len(frames)
+            self._status.last_timestamp_ms = frames[-1].timestamp_ms
+
+    def spectrogram_snapshot(self, max_frames: int) -> list[SpectrumFrame]:
+        with self._lock:
+            if max_frames <= 0:
                 return []
-            data = list(self._ring)
-        return data[-max_samples:]
+            data = list(self._spectra)
+        return data[-max_frames:]
+
+    def add_mfcc(self, frames: list[MfccFrame]) -> None:
+        """Source thread: one decoded TLV_MFCC batch."""
+        if not frames:
+            return
+        with self._lock:
+            self._mfcc.extend(frames)
+            self._status.mfcc_vectors += len(frames)
+            self._status.last_timestamp_ms = frames[-1].timestamp_ms
+
+    def mfcc_snapshot(self, max_frames: int) -> list[MfccFrame]:
+        with self._lock:
+            if max_frames <= 0:
+                return []
+            data = list(self._mfcc)
+        return data[-max_frames:]
+
+    def add_half_rate(self, frame: AudioFrame) -> None:
+        """Source thread: one TLV_PCM_HALF batch."""
+        ch = max(1, frame.channels)
+        samples = frame.samples_i16[::ch]
+        with self._lock:
+            if frame.sample_rate_hz and frame.sample_rate_hz != self._half_sr:
+                self._half_sr = frame.sample_rate_hz
+                self._half = SampleRing(int(frame.sample_rate_hz * self._wave_seconds))
+            self._half.extend(samples)
+            self._half_next = (frame.sample_index or 0) + samples.size
+            self._status.half_rate_samples += samples.size
+
+    def half_rate_snapshot(self, max_samples: int) -> tuple[Optional[int], Optional[int], np.ndarray]:
+        """(sample_rate_hz, sample index of the first sample, samples), newest last."""
+        with self._lock:
+            if self._half_next is None:
+                return self._half_sr, None, np.empty(0, dtype=np.int16)
+            data = self._half.latest(max_samples)
+            return self._half_sr, self._half_next - data.size, data
+
+    def ring_snapshot(self, max_samples: int) -> np.ndarray:
+        """Copy of the newest channel 0 samples, oldest first."""
+        return self._ring.latest(max_samples)
+
+    def ring_cursor(self) -> int:
+        """Channel 0 samples written to the current ring (the end cursor)."""
+        return self._ring.end
+
+    def ring_read(self, start: int, end: int) -> tuple[int, np.ndarray]:
+        """Channel 0 samples [start, end) by ring cursor, as far as still held."""
+        return self._ring.read(start, end)
+
+    def timestamp_at(self, cursor: int) -> Optional[int]:
+        """
+        Device timestamp_ms of the sample at ring cursor, counted in samples
+        from the newest frame that carried one. None before the first.
+        """
+        with self._lock:
+            anchor = self._ts_anchor
+        if anchor is None:
+            return None
+        at, ts, sr = anchor
+        return ts + (cursor - at) * 1000 // sr
+
+    def add_data_listener(self, cb: Callable[[], None]) -> None:
+        """cb() runs on the pump thread whenever the ring cursor moved: keep it short."""
+        with self._lock:
+            self._listeners += (cb,)
+
+    def remove_data_listener(self, cb: Callable[[], None]) -> None:
+        with self._lock:
+            self._listeners = tuple(c for c in self._listeners if c is not cb)
 
     def set_source(self, source: AudioSource) -> None:
         with self._lock:
             self._source = source
 
-    def connect(self, endpoint: str, *, baud: int, sample_rate_hz: int) -> None:
+    def connect(self, endpoint: str, *, baud: int, sample_rate_hz: int, **kwargs) -> None:
         if self._source is None:
             raise RuntimeError("No source configured")
 
         self.disconnect()
 
         self._stop.clear()
-        self._source.connect(endpoint, baud=baud, sample_rate_hz=sample_rate_hz)
+        self._source.connect(endpoint, baud=baud, sample_rate_hz=sample_rate_hz, **kwargs)
 
         with self._lock:
             self._status.connected = True
@@ -66,7 +224,26 @@ class StreamHub:
             self._status.sample_rate_hz = sample_rate_hz
             self._status.last_timestamp_ms = None
             self._status.dropped_frames = 0
-            self._ring = deque(maxlen=int(sample_rate_hz * self._wave_seconds))
+            self._status.device_stats = None
+            self._status.lost_samples = 0
+            self._status.gaps = 0
+            self._status.silent_samples = 0
+            self._status.spectra = 0
+            self._status.mfcc_vectors = 0
+            self._status.half_rate_samples = 0
+            self._status.channels = 1
+            self._status.stream_config = None
+            self._ring = SampleRing(int(sample_rate_hz * self._wave_seconds), self._ring.end)
+            self._spectra.clear()
+            self._mfcc.clear()
+            self._half = SampleRing(self._half.capacity)
+            self._half_sr = None
+            self._half_next = None
+            self._last_rx_ns = None
+            self._ts_anchor = None
+        self._next_index = None
+        self._last_sample = 0
+        self.latency.reset()
 
         self._thread = threading.Thread(target=self._pump_loop, daemon=True)
         self._thread.start()
@@ -74,7 +251,8 @@ class StreamHub:
     def disconnect(self) -> None:
         self._stop.set()
         if self._source is not None:
-            self._source.disconnect()
+            self._source.disconnect()  # ends frames(), so an idle pump sees _stop too
+        self._join_pump()
         self._recorder.stop()
         with self._lock:
             self._status.connected = False
@@ -84,12 +262,18 @@ class StreamHub:
 
     def start_recording(self) -> str:
         st = self.status()
-        path = self._recorder.start(sample_rate_hz=st.sample_rate_hz)
+        path = self._recorder.start(sample_rate_hz=st.sample_rate_hz, channels=st.channels)
         return str(path)
 
     def stop_recording(self) -> None:
         self._recorder.stop()
 
+    def _join_pump(self) -> None:
+        """Wait for the pump thread to finish (unless called from it)."""
+        th, self._thread = self._thread, None
+        if th is not None and th is not threading.current_thread():
+            th.join()
+
     def _pump_loop(self) -> None:
         assert self._source is not None
         for frame in self._source.frames():
@@ -97,10 +281,108 @@ class StreamHub:
                 break
             self._handle_frame(frame)
 
+    def _apply_format(self, frame: AudioFrame) -> None:
+        """Pump thread: follow a device stream reconfig."""
+        sr, ch = frame.sample_rate_hz, frame.channels
+        with self._lock:
+            if sr == self._status.sample_rate_hz and ch == self._status.channels:
+                return
+            self._status.sample_rate_hz = sr
+            self._status.channels = ch
+            self._ring = SampleRing(int(sr * self._wave_seconds), self._ring.end)
+        self._next_index = None
+        self.add_log(f"Stream format now {sr} Hz, {ch}ch", "ok")
+        if self._recorder.state.enabled:
+            self._recorder.stop()
+            self._recorder.start(sample_rate_hz=sr, channels=ch)
+
+    def _fill_gap(self, frame: AudioFrame) -> Optional[AudioFrame]:
+        """Returns the concealment frame for samples lost before `frame`."""
+        idx = frame.sample_index
+        if idx is None:
+            return None
+        ch = frame.channels
+        expected = self._next_index
+        self._next_index = idx + frame.samples_i16.size // ch
+        if expected is None or idx == expected:
+            return None
+        if idx < expected:
+            self.add_log(f"Sample index went back {expected} -> {idx}, device restarted?", "warn")
+            return None
+
+        lost = idx - expected
+        with self._lock:
+            self._status.lost_samples += lost
+            self._status.gaps += 1
+            sr = self._status.sample_rate_hz
+        self.add_log(f"Lost {lost} samples at index {expected}", "warn")
+
+        if lost > self._max_conceal_seconds * sr:
+            self._recorder.skip(lost)
+            return None
+
+        if self._conceal == "silence" or frame.samples_i16.size == 0 or ch > 1:
+            fill = np.zeros(lost * ch, dtype=np.int16)
+        else:
+            a, b = self._last_sample, int(frame.samples_i16[0])
+            step = np.arange(1, lost + 1, dtype=np.int64)
+            fill = (a + (b - a) * step // (lost + 1)).astype(np.int16)
+        ts = None
+        if frame.timestamp_ms is not None:
+            ts = frame.timestamp_ms - lost * 1000 // sr
+        return replace(frame, timestamp_ms=ts, samples_i16=fill, sample_index=expected,
+                       rx_ns=None, queued_ns=None, wire_bytes=0)
+
+    def _expand_silence(self, frame: AudioFrame) -> AudioFrame:
+        """Samples for a VAD silence run: noise at the device floor, or zeros."""
+        n = frame.silent_samples * frame.channels
+        with self._lock:
+            self._status.silent_samples += frame.silent_samples
+        if self._silence_fill == "zeros" or frame.noise_floor_rms == 0:
+            fill = np.zeros(n, dtype=np.int16)
+        else:
+            noise = np.rint(self._rng.normal(0.0, frame.noise_floor_rms, n))
+            fill = np.clip(noise, -32768, 32767).astype(np.int16)
+        return replace(frame, samples_i16=fill)
+
     def _handle_frame(self, frame: AudioFrame) -> None:
+        if frame.sample_rate_hz is not None:
+            self._apply_format(frame)
+        if frame.silent_samples:
+            frame = self._expand_silence(frame)
+        if frame.clip_start:
+            # nothing was lost ahead of a clip, and the recording just continues
+            self._next_index = None
+            with self._lock:
+                self._status.clips += 1
+            self.add_log(f"Triggered clip from sample {frame.sample_index}", "ok")
+        fill = self._fill_gap(frame)
+        if fill is not None:
+            self._ingest(fill)
+        self._ingest(frame)
+        if frame.samples_i16.size:
+            self._last_sample = int(frame.samples_i16[-frame.channels])
+
+    def _ingest(self, frame: AudioFrame) -> None:
+        now = time.monotonic_ns()
+        start = self._ring.end
+        self._ring.extend(frame.samples_i16[::frame.channels])
         with self._lock:
             self._status.last_timestamp_ms = frame.timestamp_ms
-            self._ring.extend(frame.samples_i16)
+            if frame.timestamp_ms is not None:
+                self._ts_anchor = (start, frame.timestamp_ms, self._status.sample_rate_hz)
+            if frame.rx_ns is not None:
+                self._last_rx_ns = frame.rx_ns
+            baud = self._status.baud
+        for cb in self._listeners:  # after the anchor, so timestamp_at() covers the new samples
+            cb()
+
+        if frame.rx_ns is not None:
+            if baud:
+                self.latency.record("wire", frame.wire_bytes * 10 * 1_000_000 // baud)
+            if frame.queued_ns is not None:
+                self.latency.record("decode", (frame.queued_ns - frame.rx_ns) // 1000)
+            self.latency.record("hub", (now - frame.rx_ns) // 1000)
 
         # CSV write outside lock
         self._recorder.write_frame(frame.timestamp_ms, frame.samples_i16)
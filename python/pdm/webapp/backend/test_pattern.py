@@ -0,0 +1,23 @@
+"""
+Device test patterns (firmware test_pattern/test_pattern.h): every sample
+is a pure function of its running sample index.
+"""
+import numpy as np
+
+
+def pattern_counter(first: int, n: int) -> np.ndarray:
+    return (np.arange(first, first + n, dtype=np.uint64) & np.uint64(0xFFFF)).astype(np.uint16).view(np.int16)
+
+
+def pattern_hash(first: int, n: int) -> np.ndarray:
+    idx = np.arange(first, first + n, dtype=np.uint64)
+    x = ((idx & np.uint64(0xFFFFFFFF)) ^ (idx >> np.uint64(32))).astype(np.uint32)
+    x ^= x >> np.uint32(16)
+    x *= np.uint32(0x7FEB352D)
+    x ^= x >> np.uint32(15)
+    x *= np.uint32(0x846CA68B)
+    x ^= x >> np.uint32(16)
+    return (x & np.uint32(0xFFFF)).astype(np.uint16).view(np.int16)
+
+
+PATTERNS = {"counter": pattern_counter, "hash": pattern_hash}
@@ -3,13 +3,23 @@ let ws = null;
 const WINDOW_SECONDS = 10;         // 10s window
 const PLOT_REFRESH_MS = 1000;      // scroll every second
 const MAX_PLOT_POINTS = 5000;      // downsample for Plotly performance
+const SPEC_FRAMES = 250;           // spectrogram columns (5 s of 20 ms blocks)
+const SPEC_DB_MIN = -110;          // colour scale, dBFS
 
 const el = (id) => document.getElementById(id);
 
 let sampleRateHz = 16000;
-let ring = [];                     // int16 samples (raw)
+let ring = new Int16Array(0);      // int16 samples (raw), circular
+let ringPos = 0;                   // next write
+let ringLen = 0;
 let totalSamples = 0;              // for time axis
 let lastFrameAt = 0;
+let lastSeq = -1;                  // binary frame sequence (per websocket)
+let nextSample = -1;               // server ring cursor after the newest sample we have
+
+// Binary PCM message (backend/main.py WS_PCM_HDR), little endian
+const WS_PCM_VERSION = 1;
+const WS_NO_TS = 0xFFFFFFFF;
 
 function nowStr() {
   const d = new Date();
@@ -173,6 +183,80 @@ function initPlot() {
 }
 
 
+function ringReset() {
+  // keep some extra beyond the plot window
+  ring = new Int16Array(Math.floor(sampleRateHz * WINDOW_SECONDS * 2));
+  ringPos = 0;
+  ringLen = 0;
+}
+
+function ringPush(samples) {
+  const cap = ring.length;
+  const src = samples.length > cap ? samples.subarray(samples.length - cap) : samples;
+  const first = Math.min(src.length, cap - ringPos);
+  ring.set(src.subarray(0, first), ringPos);
+  ring.set(src.subarray(first), 0);
+  ringPos = (ringPos + src.length) % cap;
+  ringLen = Math.min(cap, ringLen + src.length);
+}
+
+function ringLatest(n) {
+  n = Math.min(n, ringLen);
+  const start = ringPos - n;
+  if (start >= 0) return ring.slice(start, ringPos);
+  const out = new Int16Array(n);
+  out.set(ring.subarray(ring.length + start));
+  out.set(ring.subarray(0, ringPos), -start);
+  return out;
+}
+
+// Header fields and an Int16Array view of the samples, no copy
+function decodePcm(buf) {
+  const dv = new DataView(buf);
+  if (dv.getUint8(0) !== WS_PCM_VERSION) return null;
+  const hdrBytes = dv.getUint16(2, true);
+  const ts = dv.getUint32(20, true);
+  return {
+    seq: dv.getUint32(4, true),
+    firstSample: Number(dv.getBigUint64(8, true)),
+    sampleRateHz: dv.getUint32(16, true),
+    timestampMs: ts === WS_NO_TS ? null : ts,  // device time of firstSample
+    samples: new Int16Array(buf, hdrBytes, (buf.byteLength - hdrBytes) >> 1),
+  };
+}
+
+function onPcm(frame) {
+  if (frame.seq <= lastSeq) return;  // stale
+  lastSeq = frame.seq;
+
+  if (frame.sampleRateHz && frame.sampleRateHz !== sampleRateHz) {
+    sampleRateHz = frame.sampleRateHz;
+    ringReset();
+    totalSamples = 0;
+    initPlot();
+    log(`Sample rate updated to ${sampleRateHz} Hz`, "dim");
+  }
+
+  // the server sends each sample once; a jump means it skipped us ahead
+  let samples = frame.samples;
+  if (nextSample >= 0 && frame.firstSample > nextSample) {
+    log(`Fell behind, skipped ${Math.round((frame.firstSample - nextSample) * 1000 / sampleRateHz)} ms`, "warn");
+  } else if (nextSample >= 0 && frame.firstSample < nextSample) {
+    samples = samples.subarray(Math.min(samples.length, nextSample - frame.firstSample));
+  }
+  nextSample = Math.max(nextSample, frame.firstSample + frame.samples.length);
+
+  if (samples.length) {
+    ringPush(samples);
+    totalSamples += samples.length;
+    lastFrameAt = Date.now();
+  }
+
+  if (frame.timestampMs != null) {
+    el("tsVal").textContent = `${frame.timestampMs} ms`;
+  }
+}
+
 function downsampleForPlot(samples) {
   if (samples.length <= MAX_PLOT_POINTS) return samples;
 
@@ -185,7 +269,7 @@ function downsampleForPlot(samples) {
 function updatePlotScroll() {
   // update plot once per second (scroll)
   const nWindow = Math.floor(sampleRateHz * WINDOW_SECONDS);
-  const windowSamples = ring.length > nWindow ? ring.slice(ring.length - nWindow) : ring.slice();
+  const windowSamples = ringLatest(nWindow);
 
   const y = downsampleForPlot(windowSamples);
 
@@ -197,43 +281,65 @@ function updatePlotScroll() {
   Plotly.update("chart", {x: [x], y: [y]});
 }
 
+function initSpectrogram() {
+  const layout = {
+    margin: { l: 55, r: 20, t: 18, b: 40 },
+    paper_bgcolor: "white",
+    plot_bgcolor: "white",
+    xaxis: { title: "Time (s)", ticks: "outside", ticklen: 4 },
+    yaxis: { title: "Frequency (Hz)", type: "log", ticks: "outside", ticklen: 4 },
+    showlegend: false,
+  };
+  const trace = {
+    type: "heatmap",
+    x: [], y: [], z: [],
+    zmin: SPEC_DB_MIN, zmax: 0,
+    colorscale: "Viridis",
+    colorbar: { title: "dBFS", thickness: 12 },
+    hovertemplate: "%{x:.2f} s  %{y:.0f} Hz  %{z:.1f} dBFS<extra></extra>",
+  };
+  Plotly.newPlot("specChart", [trace], layout, { displayModeBar: false, responsive: true });
+}
+
+async function updateSpectrogram() {
+  const sp = await api(`/api/spectrogram?frames=${SPEC_FRAMES}`);
+  const frames = sp.frames || [];
+  if (!frames.length) return;
+
+  // one row per bin/band at the geometric centre of its edges (the
+  // first bin row would sit at 0 Hz, which a log axis cannot show)
+  const f = sp.freqs_hz;
+  const y = [];
+  for (let k = 0; k + 1 < f.length; k++) y.push(Math.sqrt(Math.max(f[k], f[1] / 2) * f[k + 1]));
+
+  const sr = sp.sample_rate_hz;
+  const x = frames.map((fr) => fr.sample_index / sr);
+  const z = y.map((_, k) => frames.map((fr) => fr.levels[k] / 2 - 127.5));
+
+  Plotly.restyle("specChart", { x: [x], y: [y], z: [z] });
+  el("specText").textContent = sp.bands
+    ? `${sp.bands} log bands, FFT ${sp.fft_size}`
+    : `${sp.fft_size / 2} bins, FFT ${sp.fft_size}`;
+}
+
 function openWS() {
   if (ws) ws.close();
   ws = new WebSocket(`ws://${location.host}/ws`);
+  ws.binaryType = "arraybuffer";
+  lastSeq = -1;
+  nextSample = -1;
 
   ws.onopen = () => log("WebSocket connected", "ok");
   ws.onclose = () => log("WebSocket disconnected", "bad");
 
   ws.onmessage = (evt) => {
-    const msg = JSON.parse(evt.data);
-
-    if (msg.type === "frame") {
-      const data = msg.data;
-      const samples = data.samples || [];
-
-      if (data.sample_rate_hz && data.sample_rate_hz !== sampleRateHz) {
-        sampleRateHz = data.sample_rate_hz;
-        ring = [];
-        totalSamples = 0;
-        initPlot();
-        log(`Sample rate updated to ${sampleRateHz} Hz`, "dim");
-      }
-
-      if (samples.length) {
-        ring = ring.concat(samples);
-        totalSamples += samples.length;
-
-        // keep ring from growing forever
-        const cap = Math.floor(sampleRateHz * WINDOW_SECONDS * 2); // keep some extra
-        if (ring.length > cap) ring = ring.slice(ring.length - cap);
-
-        lastFrameAt = Date.now();
-      }
-
-      if (data.timestamp_ms != null) {
-        el("tsVal").textContent = `${data.timestamp_ms} ms`;
-      }
+    // audio is binary, logs are JSON text
+    if (evt.data instanceof ArrayBuffer) {
+      const frame = decodePcm(evt.data);
+      if (frame) onPcm(frame);
+      return;
     }
+    const msg = JSON.parse(evt.data);
 
     if (msg.type === "log") {
       log(msg.data?.message || "log", msg.data?.level || "dim");
@@ -277,7 +383,7 @@ async function connect() {
 
   // reset plotting buffers on connect
   sampleRateHz = sr;
-  ring = [];
+  ringReset();
   totalSamples = 0;
   initPlot();
 
@@ -304,13 +410,16 @@ el("clearLogsBtn").addEventListener("click", () => {
 
 (async function boot() {
   log("UI loaded", "dim");
+  ringReset();
   await loadPorts();
   openWS();
   initPlot();
+  initSpectrogram();
   await refreshStatus();
 
   // scroll plot once per second
   setInterval(updatePlotScroll, PLOT_REFRESH_MS);
+  setInterval(() => updateSpectrogram().catch(() => {}), PLOT_REFRESH_MS);
 
   // keep status in sync
   setInterval(refreshStatus, 800);